@@ -0,0 +1,139 @@
+// bounded_queue.h
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+/*
+Lock-free queue of fixed capacity for many producers and many consumers.
+Each cell has a sequence number telling whether the cell is ready for writing or reading,
+so producers and consumers synchronize on the cells only. Capacity is rounded up to a power of two.
+The cells are raw storage, the values are constructed on push and destroyed on pop, so a large queue costs its memory only.
+//BoundedQueue<std::string> queue(1024);
+//queue.try_push(std::string("item"));
+//std::string item;
+//if (queue.try_pop(item)) ...
+*/
+template<typename T> class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		cells_.reset(new Cell[size]);
+		mask_ = size - 1;
+		for (size_t i = 0; i < size; i++) cells_[i].sequence.store(i, std::memory_order_relaxed);
+		enqueue_.store(0, std::memory_order_relaxed);
+		dequeue_.store(0, std::memory_order_relaxed);
+	}
+	~BoundedQueue()
+	{
+		// no concurrent operations here, so all the cells between the positions hold values
+		size_t enqueue = enqueue_.load(std::memory_order_acquire);
+		for (size_t pos = dequeue_.load(std::memory_order_acquire); pos != enqueue; pos++) cells_[pos & mask_].value()->~T();
+	}
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	size_t capacity() const { return mask_ + 1; }
+
+	// approximate count of the items, exact if there are no concurrent operations
+	size_t size() const
+	{
+		size_t dequeue = dequeue_.load(std::memory_order_acquire);
+		size_t enqueue = enqueue_.load(std::memory_order_acquire);
+		return enqueue > dequeue ? enqueue - dequeue : 0;
+	}
+	bool empty() const { return size() == 0; }
+
+	// moves the value into the queue, returns false if the queue is full
+	bool try_push(T&& value)
+	{
+		Cell* cell = nullptr;
+		size_t pos = enqueue_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_.load(std::memory_order_relaxed);
+			}
+		}
+		new (cell->value()) T(std::move(value));
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// moves the oldest value out of the queue, returns false if the queue is empty
+	bool try_pop(T& value)
+	{
+		Cell* cell = nullptr;
+		size_t pos = dequeue_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeue_.load(std::memory_order_relaxed);
+			}
+		}
+		T* item = cell->value();
+		value = std::move(*item);
+		item->~T();
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct Cell
+	{
+		T* value() { return reinterpret_cast<T*>(&storage); }
+
+		std::atomic<size_t> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+	};
+
+	// producers and consumers positions are kept in separate cache lines
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_ = 0;
+	char pad0_[64];
+	std::atomic<size_t> enqueue_;
+	char pad1_[64];
+	std::atomic<size_t> dequeue_;
+	char pad2_[64];
+};
+
+}
+
+#pragma pack(pop)
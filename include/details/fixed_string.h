@@ -0,0 +1,101 @@
+// fixed_string.h
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+/*
+String of at most N chars kept inside the object, so short strings like ids and codes need no heap allocation.
+Assigning a longer string throws std::length_error.
+//FixedString<8> code("EUR");
+//std::string s = code.str();
+//if (code == "EUR") ...
+*/
+template<size_t N>
+class FixedString
+{
+public:
+	typedef char value_type;
+	typedef size_t size_type;
+	typedef const char* const_iterator;
+	// maximal length of the string
+	static const size_t fixed_capacity = N;
+
+public:
+	FixedString() { data_[0] = '\0'; }
+	FixedString(const char* s) { assign(s, std::strlen(s)); }
+	FixedString(const char* s, size_type len) { assign(s, len); }
+	FixedString(const std::string& s) { assign(s.data(), s.size()); }
+
+	FixedString& operator=(const char* s) { assign(s, std::strlen(s)); return *this; }
+	FixedString& operator=(const std::string& s) { assign(s.data(), s.size()); return *this; }
+
+	// replaces the content, throws std::length_error if the string is longer than N
+	void assign(const char* s, size_type len)
+	{
+		if (!try_assign(s, len)) throw std::length_error("FixedString capacity exceeded");
+	}
+	// replaces the content, returns false and keeps the content if the string is longer than N
+	bool try_assign(const char* s, size_type len)
+	{
+		if (len > N) return false;
+		std::memmove(data_, s, len);
+		data_[len] = '\0';
+		size_ = len;
+		return true;
+	}
+	void clear()
+	{
+		data_[0] = '\0';
+		size_ = 0;
+	}
+
+	const_iterator begin() const { return data_; }
+	const_iterator end() const { return data_ + size_; }
+	const char* data() const { return data_; }
+	const char* c_str() const { return data_; }
+	bool empty() const { return size_ == 0; }
+	size_type size() const { return size_; }
+	size_type length() const { return size_; }
+	static size_type capacity() { return N; }
+	char operator[](size_type i) const { return data_[i]; }
+
+	std::string str() const { return std::string(data_, size_); }
+
+	int compare(const char* s, size_type len) const
+	{
+		int c = std::memcmp(data_, s, size_ < len ? size_ : len);
+		if (c != 0) return c;
+		return size_ < len ? -1 : (size_ > len ? 1 : 0);
+	}
+
+	friend bool operator==(const FixedString& op1, const FixedString& op2) { return op1.compare(op2.data_, op2.size_) == 0; }
+	friend bool operator!=(const FixedString& op1, const FixedString& op2) { return !(op1 == op2); }
+	friend bool operator<(const FixedString& op1, const FixedString& op2) { return op1.compare(op2.data_, op2.size_) < 0; }
+	friend bool operator==(const FixedString& op, const std::string& s) { return op.compare(s.data(), s.size()) == 0; }
+	friend bool operator==(const std::string& s, const FixedString& op) { return op == s; }
+	friend bool operator==(const FixedString& op, const char* s) { return op.compare(s, std::strlen(s)) == 0; }
+	friend bool operator==(const char* s, const FixedString& op) { return op == s; }
+
+private:
+	char data_[N + 1];
+	size_type size_ = 0;
+};
+
+template<size_t N> inline
+std::ostream& operator<<(std::ostream& os, const FixedString<N>& s)
+{
+	return os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+}
+
+#pragma pack(pop)
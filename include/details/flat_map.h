@@ -0,0 +1,175 @@
+// flat_map.h
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+// comparator of different types of keys, e.g. std::string and const char*, lookup does not create temporary keys
+struct TransparentLess
+{
+	template<typename T1, typename T2> bool operator()(const T1& op1, const T2& op2) const
+	{
+		return op1 < op2;
+	}
+};
+
+/*
+Associative container keeping sorted pairs in one contiguous vector.
+Lookup is a binary search over the contiguous memory, iteration is in the sorted keys order.
+Insertion of a single item moves the items after it, so bulk building should use
+emplace_back_unsorted() calls followed by sort_unique().
+//FlatMap<std::string, int> labels;
+//labels.reserve(2);
+//labels.emplace_back_unsorted("region", 1);
+//labels.emplace_back_unsorted("host", 2);
+//labels.sort_unique();
+//auto it = labels.find("host"); // no temporary std::string is created
+*/
+template<typename Key, typename T, typename Compare = TransparentLess>
+class FlatMap
+{
+public:
+	typedef Key key_type;
+	typedef T mapped_type;
+	typedef std::pair<Key, T> value_type;
+	typedef std::vector<value_type> container_type;
+	typedef typename container_type::iterator iterator;
+	typedef typename container_type::const_iterator const_iterator;
+	typedef typename container_type::size_type size_type;
+
+public:
+	FlatMap() = default;
+	explicit FlatMap(const Compare& comp): comp_(comp) {}
+	FlatMap(std::initializer_list<value_type> items)
+	{
+		items_.assign(items.begin(), items.end());
+		sort_unique();
+	}
+
+	iterator begin() { return items_.begin(); }
+	iterator end() { return items_.end(); }
+	const_iterator begin() const { return items_.begin(); }
+	const_iterator end() const { return items_.end(); }
+
+	bool empty() const { return items_.empty(); }
+	size_type size() const { return items_.size(); }
+	void clear() { items_.clear(); }
+	void reserve(size_type n) { items_.reserve(n); }
+
+	template<typename K> iterator lower_bound(const K& key)
+	{
+		return std::lower_bound(items_.begin(), items_.end(), key, KeyCompare(comp_));
+	}
+	template<typename K> const_iterator lower_bound(const K& key) const
+	{
+		return std::lower_bound(items_.begin(), items_.end(), key, KeyCompare(comp_));
+	}
+
+	template<typename K> iterator find(const K& key)
+	{
+		iterator it = lower_bound(key);
+		return (it != items_.end() && !comp_(key, it->first)) ? it : items_.end();
+	}
+	template<typename K> const_iterator find(const K& key) const
+	{
+		const_iterator it = lower_bound(key);
+		return (it != items_.end() && !comp_(key, it->first)) ? it : items_.end();
+	}
+
+	template<typename K> size_type count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+	template<typename K> T& at(const K& key)
+	{
+		iterator it = find(key);
+		if (it == end()) throw std::out_of_range("FlatMap key not found");
+		return it->second;
+	}
+	template<typename K> const T& at(const K& key) const
+	{
+		const_iterator it = find(key);
+		if (it == end()) throw std::out_of_range("FlatMap key not found");
+		return it->second;
+	}
+
+	T& operator[](const Key& key) { return emplace(key, T()).first->second; }
+	T& operator[](Key&& key) { return emplace(std::move(key), T()).first->second; }
+
+	// inserts the item keeping the order, returns existing item if the key is already present
+	template<typename K, typename V> std::pair<iterator, bool> emplace(K&& key, V&& value)
+	{
+		iterator it = lower_bound(key);
+		if (it != items_.end() && !comp_(key, it->first)) return std::make_pair(it, false);
+		it = items_.emplace(it, std::forward<K>(key), std::forward<V>(value));
+		return std::make_pair(it, true);
+	}
+	std::pair<iterator, bool> insert(const value_type& item) { return emplace(item.first, item.second); }
+	std::pair<iterator, bool> insert(value_type&& item) { return emplace(std::move(item.first), std::move(item.second)); }
+
+	template<typename K> size_type erase(const K& key)
+	{
+		iterator it = find(key);
+		if (it == end()) return 0;
+		items_.erase(it);
+		return 1;
+	}
+	// both iterator overloads are needed, the key template would be taken for the non-const iterator
+	iterator erase(iterator it) { return items_.erase(it); }
+	iterator erase(const_iterator it) { return items_.erase(it); }
+
+	// appends the item without ordering, sort_unique() must be called after the items are appended
+	template<typename K, typename V> void emplace_back_unsorted(K&& key, V&& value)
+	{
+		items_.emplace_back(std::forward<K>(key), std::forward<V>(value));
+	}
+
+	// restores the order after unsorted appending, the last appended item wins for duplicate keys
+	void sort_unique()
+	{
+		KeyCompare comp(comp_);
+		if (std::is_sorted(items_.begin(), items_.end(), comp) &&
+			std::adjacent_find(items_.begin(), items_.end(), [&comp](const value_type& a, const value_type& b) { return !comp(a, b); }) == items_.end())
+		{
+			return;
+		}
+		std::stable_sort(items_.begin(), items_.end(), comp);
+		// keep the last of equal keys
+		iterator out = items_.begin();
+		for (iterator it = items_.begin(); it != items_.end(); ++it)
+		{
+			iterator next = it + 1;
+			if (next != items_.end() && !comp(*it, *next)) continue;
+			if (out != it) *out = std::move(*it);
+			++out;
+		}
+		items_.erase(out, items_.end());
+	}
+
+	friend bool operator==(const FlatMap& op1, const FlatMap& op2) { return op1.items_ == op2.items_; }
+	friend bool operator!=(const FlatMap& op1, const FlatMap& op2) { return !(op1 == op2); }
+
+private:
+	// compares items with items and items with keys
+	struct KeyCompare
+	{
+		explicit KeyCompare(const Compare& comp): comp_(comp) {}
+		bool operator()(const value_type& op1, const value_type& op2) const { return comp_(op1.first, op2.first); }
+		template<typename K> bool operator()(const value_type& op1, const K& op2) const { return comp_(op1.first, op2); }
+		template<typename K> bool operator()(const K& op1, const value_type& op2) const { return comp_(op1, op2.first); }
+		const Compare& comp_;
+	};
+
+	container_type items_;
+	Compare comp_;
+};
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,192 @@
+// interned_string.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <ostream>
+#include <functional>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+/*
+Process wide table of interned strings. The table is split into shards by the hash, each shard has its own lock,
+so threads parsing different values rarely wait for each other. A known string is found by its bytes without allocation.
+The strings are never removed, so the table is for values of low cardinality: host names, region codes, metric names.
+Reading untrusted input may add any count of new strings, so the limit bounds the table:
+new strings over the limit are not interned, intern() throws std::length_error and reading of the field fails.
+//InternTable::instance().setLimit(100000);
+*/
+class InternTable
+{
+public:
+	struct Entry
+	{
+		std::string value;
+		uint64_t hash;
+	};
+
+public:
+	static InternTable& instance()
+	{
+		// never destroyed, so interned strings of static objects stay valid at exit
+		static InternTable* table = new InternTable();
+		return *table;
+	}
+
+	// returns the entry of the string, the entry is created if the string is new.
+	// Throws std::length_error if the string is new and the table has the limit count of strings.
+	const Entry* intern(const char* s, size_t len)
+	{
+		uint64_t h = hash(s, len);
+		Shard& shard = shards_[h >> (64 - shardBits)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		size_t mask = shard.slots.size() - 1;
+		for (size_t i = static_cast<size_t>(h) & mask;; i = (i + 1) & mask)
+		{
+			const Entry* entry = shard.slots[i];
+			if (!entry) break;
+			if (entry->hash == h && entry->value.size() == len && std::memcmp(entry->value.data(), s, len) == 0) return entry;
+		}
+
+		if (count_.fetch_add(1, std::memory_order_relaxed) >= limit_.load(std::memory_order_relaxed))
+		{
+			count_.fetch_sub(1, std::memory_order_relaxed);
+			throw std::length_error("InternTable limit exceeded");
+		}
+		shard.entries.push_back(Entry{ std::string(s, len), h });
+		const Entry* entry = &shard.entries.back();
+		if ((shard.entries.size() + 1) * 2 > shard.slots.size()) rehash(shard, shard.slots.size() * 2);
+		else place(shard, entry);
+		return entry;
+	}
+
+	// count of the interned strings
+	size_t size() const { return count_.load(std::memory_order_relaxed); }
+
+	// maximal count of the interned strings, not limited by default. Lower limit keeps the strings already interned.
+	void setLimit(size_t limit) { limit_.store(limit, std::memory_order_relaxed); }
+	size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+
+	// FNV-1a
+	static uint64_t hash(const char* s, size_t len)
+	{
+		uint64_t h = 14695981039346656037ull;
+		for (size_t i = 0; i < len; i++)
+		{
+			h ^= static_cast<unsigned char>(s[i]);
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+private:
+	static const unsigned shardBits = 4;
+	static const size_t shardCount = size_t(1) << shardBits;
+
+	struct Shard
+	{
+		mutable std::mutex mutex;
+		// entries keep their addresses while the deque grows
+		std::deque<Entry> entries;
+		// open addressing table of the entries, the size is the power of 2
+		std::vector<const Entry*> slots = std::vector<const Entry*>(16, nullptr);
+	};
+
+	InternTable() = default;
+	InternTable(const InternTable&) = delete;
+	InternTable& operator=(const InternTable&) = delete;
+
+	static void place(Shard& shard, const Entry* entry)
+	{
+		size_t mask = shard.slots.size() - 1;
+		size_t i = static_cast<size_t>(entry->hash) & mask;
+		while (shard.slots[i]) i = (i + 1) & mask;
+		shard.slots[i] = entry;
+	}
+
+	static void rehash(Shard& shard, size_t size)
+	{
+		shard.slots.assign(size, nullptr);
+		for (const Entry& entry: shard.entries) place(shard, &entry);
+	}
+
+private:
+	Shard shards_[shardCount];
+	std::atomic<size_t> count_{ 0 };
+	std::atomic<size_t> limit_{ std::numeric_limits<size_t>::max() };
+};
+
+/*
+Immutable string kept once in InternTable: equal strings share one copy, so objects holding repeated values
+keep a pointer each, and equality is a pointer compare. Reading of a known value from json text allocates nothing.
+//InternedString region("eu-west-1");
+//if (region == other.region) ... // compares the pointers
+//std::string s = region.str();
+The table keeps every string ever interned, so fields read from untrusted input need InternTable::setLimit().
+*/
+class InternedString
+{
+public:
+	InternedString(): entry_(emptyEntry()) {}
+	InternedString(const char* s): entry_(InternTable::instance().intern(s, std::strlen(s))) {}
+	InternedString(const char* s, size_t len): entry_(InternTable::instance().intern(s, len)) {}
+	InternedString(const std::string& s): entry_(InternTable::instance().intern(s.data(), s.size())) {}
+
+	const std::string& str() const { return entry_->value; }
+	const char* data() const { return entry_->value.data(); }
+	const char* c_str() const { return entry_->value.c_str(); }
+	size_t size() const { return entry_->value.size(); }
+	size_t length() const { return entry_->value.size(); }
+	bool empty() const { return entry_->value.empty(); }
+	// hash of the string's bytes, computed once when the string is interned
+	size_t hash() const { return static_cast<size_t>(entry_->hash); }
+
+	friend bool operator==(const InternedString& op1, const InternedString& op2) { return op1.entry_ == op2.entry_; }
+	friend bool operator!=(const InternedString& op1, const InternedString& op2) { return op1.entry_ != op2.entry_; }
+	// ordering is by the content, so sorted containers keep the same order as for std::string
+	friend bool operator<(const InternedString& op1, const InternedString& op2) { return op1.entry_ != op2.entry_ && op1.str() < op2.str(); }
+	friend bool operator==(const InternedString& op, const std::string& s) { return op.str() == s; }
+	friend bool operator==(const std::string& s, const InternedString& op) { return op.str() == s; }
+	friend bool operator==(const InternedString& op, const char* s) { return op.str() == s; }
+	friend bool operator==(const char* s, const InternedString& op) { return op.str() == s; }
+
+private:
+	static const InternTable::Entry* emptyEntry()
+	{
+		static const InternTable::Entry* entry = InternTable::instance().intern("", 0);
+		return entry;
+	}
+
+private:
+	const InternTable::Entry* entry_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const InternedString& s)
+{
+	return os << s.str();
+}
+
+}
+
+namespace std
+{
+
+template<> struct hash<utils::InternedString>
+{
+	size_t operator()(const utils::InternedString& s) const { return s.hash(); }
+};
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,61 @@
+// json_consumer.h
+#pragma once
+
+#include <functional>
+#include <cstddef>
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Array field which items are passed to the consumer one by one while the object is loaded, the items are not kept.
+So arrays of millions of items are read with the memory of one item, when json text is read directly.
+The consumer is set to the field before loading and the loaded object keeps it.
+Consumers of nested JsonEx objects are kept too, except the objects inside arrays, maps and nullables.
+The consumer returns false to stop reading, then loading fails. The field is written as an empty array.
+//using data_type = std::tuple<std::string, Json::JsonExConsumer<CRowType>>;
+//obj.set<AttrRows>(Json::JsonExConsumer<CRowType>([&db](CRowType&& row) { return db.insert(row); }));
+//bool b = obj.load(hugeJsonText);
+//size_t rows = obj.get<AttrRows>().size();
+*/
+template<typename T> class JsonExConsumer
+{
+public:
+	typedef T value_type;
+	// receives the next item, returns false to stop reading
+	typedef std::function<bool(T&&)> consumer_type;
+
+public:
+	JsonExConsumer() = default;
+	explicit JsonExConsumer(consumer_type consumer): consumer_(std::move(consumer)) {}
+
+	const consumer_type& consumer() const { return consumer_; }
+	// count of the items read by the last load
+	size_t size() const { return size_; }
+
+	// passes the item to the consumer, returns false if the consumer stops reading.
+	// The items are dropped if there is no consumer.
+	bool consume(T&& item)
+	{
+		size_++;
+		return !consumer_ || consumer_(std::move(item));
+	}
+	// starts reading of the new array
+	void reset() { size_ = 0; }
+	// takes the consumer of the loaded object's field before reading
+	void prepare(const JsonExConsumer& source)
+	{
+		consumer_ = source.consumer_;
+		size_ = 0;
+	}
+
+private:
+	consumer_type consumer_;
+	size_t size_ = 0;
+};
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,186 @@
+// json_enum.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#include "json_escape.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Names of the enumerators for json text. Names are found by the perfect hash built once for the table:
+one hash, one slot and one compare per lookup. Enumerators are found by the index if the values are contiguous,
+else by the binary search. Quoted and escaped names are prepared for writing.
+Several names of one value are allowed, the first of them is written.
+*/
+template<typename E> class JsonExEnumNames
+{
+	static_assert(std::is_enum<E>::value, "JsonExEnumNames is for enum types only");
+
+public:
+	typedef E value_type;
+	typedef typename std::underlying_type<E>::type underlying_type;
+	typedef std::pair<E, const char*> item_type;
+
+public:
+	// throws std::invalid_argument if the names are not unique
+	JsonExEnumNames(std::initializer_list<item_type> items)
+	{
+		for (const item_type& item: items) names_.push_back(Name{ item.first, item.second, std::string() });
+		for (Name& name: names_) utils::json_quote(name.literal, name.name.data(), name.name.size());
+		makeHash();
+		makeValues();
+	}
+	JsonExEnumNames(const JsonExEnumNames&) = delete;
+	JsonExEnumNames& operator=(const JsonExEnumNames&) = delete;
+
+	// finds the enumerator by the name, returns false if the name is unknown
+	bool find(const char* s, size_t len, E& value) const
+	{
+		uint32_t slot = hash(seed_, s, len) & mask_;
+		size_t i = slots_[slot];
+		if (!i) return false;
+		const Name& name = names_[i - 1];
+		if (name.name.size() != len || name.name.compare(0, len, s, len) != 0) return false;
+		value = name.value;
+		return true;
+	}
+
+	// returns the name of the enumerator, or nullptr if the value has no name
+	const std::string* name(E value) const
+	{
+		size_t i = index(value);
+		return i < names_.size() ? &names_[i].name : nullptr;
+	}
+
+	// returns the quoted and escaped name for json text, or nullptr if the value has no name
+	const std::string* literal(E value) const
+	{
+		size_t i = index(value);
+		return i < names_.size() ? &names_[i].literal : nullptr;
+	}
+
+	size_t size() const { return names_.size(); }
+
+private:
+	struct Name
+	{
+		E value;
+		std::string name;
+		std::string literal;
+	};
+
+	// FNV-1a with the seed
+	static uint32_t hash(uint32_t seed, const char* s, size_t len)
+	{
+		uint32_t h = 2166136261u ^ seed;
+		for (size_t i = 0; i < len; i++)
+		{
+			h ^= static_cast<unsigned char>(s[i]);
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	// searches the seed placing every name into its own slot, the table grows if no seed is found
+	void makeHash()
+	{
+		for (size_t i = 0; i < names_.size(); i++)
+		{
+			for (size_t j = 0; j < i; j++)
+			{
+				if (names_[i].name == names_[j].name) throw std::invalid_argument("Duplicate enum name '" + names_[i].name + "'");
+			}
+		}
+		size_t size = 2;
+		while (size < names_.size() * 2) size *= 2;
+		for (;; size *= 2)
+		{
+			slots_.assign(size, 0);
+			mask_ = static_cast<uint32_t>(size - 1);
+			for (seed_ = 0; seed_ < 256; seed_++)
+			{
+				std::fill(slots_.begin(), slots_.end(), 0);
+				size_t i = 0;
+				for (; i < names_.size(); i++)
+				{
+					size_t& slot = slots_[hash(seed_, names_[i].name.data(), names_[i].name.size()) & mask_];
+					if (slot) break;
+					slot = i + 1;
+				}
+				if (i == names_.size()) return;
+			}
+		}
+	}
+
+	// sorts the values for the search, keeping the first name of each value
+	void makeValues()
+	{
+		for (size_t i = 0; i < names_.size(); i++) values_.push_back(std::make_pair(static_cast<underlying_type>(names_[i].value), i));
+		std::stable_sort(values_.begin(), values_.end(), [](const std::pair<underlying_type, size_t>& op1, const std::pair<underlying_type, size_t>& op2)
+		{
+			return op1.first < op2.first;
+		});
+		values_.erase(std::unique(values_.begin(), values_.end(), [](const std::pair<underlying_type, size_t>& op1, const std::pair<underlying_type, size_t>& op2)
+		{
+			return op1.first == op2.first;
+		}), values_.end());
+		contiguous_ = !values_.empty();
+		for (size_t i = 1; i < values_.size() && contiguous_; i++) contiguous_ = values_[i].first == values_[i - 1].first + 1;
+	}
+
+	// returns the index of the value's name, or the size of the table if the value has no name
+	size_t index(E value) const
+	{
+		underlying_type v = static_cast<underlying_type>(value);
+		if (contiguous_)
+		{
+			if (v < values_.front().first || v > values_.back().first) return names_.size();
+			return values_[static_cast<size_t>(v - values_.front().first)].second;
+		}
+		auto it = std::lower_bound(values_.begin(), values_.end(), v, [](const std::pair<underlying_type, size_t>& op, underlying_type key)
+		{
+			return op.first < key;
+		});
+		return it != values_.end() && it->first == v ? it->second : names_.size();
+	}
+
+private:
+	std::vector<Name> names_;
+	// index + 1 of the name in each slot of the hash, 0 is the empty slot
+	std::vector<size_t> slots_;
+	uint32_t seed_ = 0;
+	uint32_t mask_ = 0;
+	// sorted values and their name indexes
+	std::vector<std::pair<underlying_type, size_t>> values_;
+	bool contiguous_ = false;
+};
+
+/*
+Enum fields are written as strings. The specialization must be defined before the enum is used as JsonEx field:
+//enum class EState { Idle, Busy };
+//template<> struct Json::JsonExEnumTraits<EState>
+//{
+//	static const JsonExEnumNames<EState>& names()
+//	{
+//		static const JsonExEnumNames<EState> n{ { EState::Idle, "idle" }, { EState::Busy, "busy" } };
+//		return n;
+//	}
+//};
+*/
+template<typename E> struct JsonExEnumTraits;
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,271 @@
+// json_escape.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Vectorized kernels are selected at compile time by the target instruction set,
+// define JSONEX_NO_SIMD to use the portable implementation only.
+#if !defined(JSONEX_NO_SIMD)
+#if defined(__AVX2__)
+#define JSONEX_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSONEX_SSE2
+#endif
+#endif
+
+#if defined(JSONEX_AVX2)
+#include <immintrin.h>
+#elif defined(JSONEX_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+///////////////////////////////////////////////////////////////////////////////
+
+// index of the lowest set bit, mask must not be zero
+inline unsigned json_lowest_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// returns true if the character must be escaped inside json string
+inline bool json_is_escaped_char(unsigned char c)
+{
+	return c < 0x20 || c == '"' || c == '\\';
+}
+
+/*
+Returns the pointer to the first quote or backslash in the range, or the end of the range.
+If _Control is true, control characters (less than 0x20) are searched as well.
+Long runs of the other bytes are skipped by 32 (AVX2), 16 (SSE2) or 8 (portable) bytes at once.
+*/
+template<bool _Control> inline const char* json_find_special(const char* p, const char* end)
+{
+#if defined(JSONEX_AVX2)
+	{
+		const __m256i quote = _mm256_set1_epi8('"');
+		const __m256i backslash = _mm256_set1_epi8('\\');
+		const __m256i control = _mm256_set1_epi8(0x1F);
+		for (; end - p >= 32; p += 32)
+		{
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			__m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(c, quote), _mm256_cmpeq_epi8(c, backslash));
+			// unsigned c <= 0x1F
+			if (_Control) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(c, control), control));
+			unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+			if (mask) return p + json_lowest_bit(mask);
+		}
+	}
+#endif
+#if defined(JSONEX_SSE2) || defined(JSONEX_AVX2)
+	{
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i control = _mm_set1_epi8(0x1F);
+		for (; end - p >= 16; p += 16)
+		{
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i m = _mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, backslash));
+			if (_Control) m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(c, control), control));
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+			if (mask) return p + json_lowest_bit(mask);
+		}
+	}
+#endif
+	{
+		// portable version checks 8 bytes at once and finds the exact position in the found block only
+		const uint64_t ones = 0x0101010101010101ull;
+		const uint64_t highs = 0x8080808080808080ull;
+		for (; end - p >= 8; p += 8)
+		{
+			uint64_t x;
+			std::memcpy(&x, p, sizeof(x));
+			uint64_t q = x ^ (ones * '"');
+			uint64_t b = x ^ (ones * '\\');
+			uint64_t t = ((q - ones) & ~q) | ((b - ones) & ~b);
+			if (_Control) t |= (x - ones * 0x20) & ~x;
+			if (t & highs) break;
+		}
+	}
+	for (; p != end; ++p)
+	{
+		unsigned char c = static_cast<unsigned char>(*p);
+		if (c == '"' || c == '\\' || (_Control && c < 0x20)) return p;
+	}
+	return end;
+}
+
+// returns the pointer to the first character which must be escaped, or the end of the range
+inline const char* json_find_escaped(const char* p, const char* end)
+{
+	return json_find_special<true>(p, end);
+}
+
+// returns the pointer to the first quote or backslash, or the end of the range
+inline const char* json_find_quote(const char* p, const char* end)
+{
+	return json_find_special<false>(p, end);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// appends escaped character to the output string
+inline void json_escape_char(std::string& out, unsigned char c)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	switch (c)
+	{
+	case '"': out.append("\\\"", 2); break;
+	case '\\': out.append("\\\\", 2); break;
+	case '\b': out.append("\\b", 2); break;
+	case '\f': out.append("\\f", 2); break;
+	case '\n': out.append("\\n", 2); break;
+	case '\r': out.append("\\r", 2); break;
+	case '\t': out.append("\\t", 2); break;
+	default:
+		{
+			const char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+			out.append(u, sizeof(u));
+		}
+		break;
+	}
+}
+
+/*
+Appends quoted and escaped json string to the output.
+Escaping is the same as jsoncpp writer does: quote, backslash, \b \f \n \r \t
+and other control characters as \u00XX, all other bytes are copied as is.
+*/
+inline void json_quote(std::string& out, const char* s, size_t len)
+{
+	out.reserve(out.size() + len + 2);
+	out.push_back('"');
+	const char* end = s + len;
+	for (;;)
+	{
+		const char* p = json_find_escaped(s, end);
+		out.append(s, p - s);
+		if (p == end) break;
+		json_escape_char(out, static_cast<unsigned char>(*p));
+		s = p + 1;
+	}
+	out.push_back('"');
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// appends UTF-8 encoded code point to the output string
+inline void json_append_utf8(std::string& out, unsigned cp)
+{
+	if (cp <= 0x7F)
+	{
+		out.push_back(static_cast<char>(cp));
+	}
+	else if (cp <= 0x7FF)
+	{
+		out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+	else if (cp <= 0xFFFF)
+	{
+		out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+	else
+	{
+		out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+}
+
+// parses 4 hex digits of \uXXXX escape sequence, returns false if the digits are invalid
+inline bool json_parse_hex4(const char* p, unsigned& cp)
+{
+	cp = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		char c = p[i];
+		cp <<= 4;
+		if (c >= '0' && c <= '9') cp += c - '0';
+		else if (c >= 'a' && c <= 'f') cp += c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') cp += c - 'A' + 10;
+		else return false;
+	}
+	return true;
+}
+
+/*
+Decodes the content of json string (without quotes) and appends it to the output.
+Runs of the bytes without escapes are copied at once.
+Returns nullptr on success, or the pointer to the invalid escape sequence.
+*/
+inline const char* json_unescape(std::string& out, const char* p, const char* end)
+{
+	out.reserve(out.size() + (end - p));
+	for (;;)
+	{
+		const char* q = json_find_quote(p, end);
+		out.append(p, q - p);
+		if (q == end) return nullptr;
+		if (*q == '"') return q;
+		if (end - q < 2) return q;
+
+		p = q + 2;
+		switch (q[1])
+		{
+		case '"': out.push_back('"'); break;
+		case '\\': out.push_back('\\'); break;
+		case '/': out.push_back('/'); break;
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u':
+			{
+				unsigned cp = 0;
+				if (end - p < 4 || !json_parse_hex4(p, cp)) return q;
+				p += 4;
+				if (cp >= 0xD800 && cp <= 0xDBFF)
+				{
+					// surrogate pair, the next \u escape is taken as the second half the same as jsoncpp reader does
+					unsigned low = 0;
+					if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !json_parse_hex4(p + 2, low)) return q;
+					cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+					p += 6;
+				}
+				json_append_utf8(out, cp);
+			}
+			break;
+		default:
+			return q;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,86 @@
+// json_extras.h
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "json_escape.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Members of json object which are not described by JsonEx type, kept as json text.
+The text is a list of "key":value members separated by commas, the values are copied from the input
+without white spaces and comments, so the members are written back as compact json without decoding and encoding.
+*/
+class JsonExExtras
+{
+public:
+	// positions of the member's quoted key and value in the text
+	struct Member
+	{
+		size_t keyBegin;
+		size_t keyEnd;
+		size_t valueBegin;
+		size_t valueEnd;
+	};
+
+public:
+	bool empty() const { return members_.empty(); }
+	size_t size() const { return members_.size(); }
+	void clear()
+	{
+		text_.clear();
+		members_.clear();
+	}
+
+	// json text of all the members without the enclosing braces
+	const std::string& text() const { return text_; }
+	const std::vector<Member>& members() const { return members_; }
+
+	// decoded key of the member
+	std::string key(size_t index) const
+	{
+		const Member& m = members_[index];
+		std::string s;
+		utils::json_unescape(s, text_.data() + m.keyBegin + 1, text_.data() + m.keyEnd - 1);
+		return s;
+	}
+
+	// json text of the member's value
+	std::string value(size_t index) const
+	{
+		const Member& m = members_[index];
+		return text_.substr(m.valueBegin, m.valueEnd - m.valueBegin);
+	}
+
+	// appends the member with decoded key and json text of the value
+	void append(const char* key, size_t keyLen, const char* value, size_t valueLen)
+	{
+		if (!text_.empty()) text_.push_back(',');
+		Member m;
+		m.keyBegin = text_.size();
+		utils::json_quote(text_, key, keyLen);
+		m.keyEnd = text_.size();
+		text_.push_back(':');
+		m.valueBegin = text_.size();
+		text_.append(value, valueLen);
+		m.valueEnd = text_.size();
+		members_.push_back(m);
+	}
+	void append(const std::string& key, const std::string& value) { append(key.data(), key.size(), value.data(), value.size()); }
+
+	friend bool operator==(const JsonExExtras& op1, const JsonExExtras& op2) { return op1.text_ == op2.text_; }
+	friend bool operator!=(const JsonExExtras& op1, const JsonExExtras& op2) { return !(op1 == op2); }
+
+private:
+	std::string text_;
+	std::vector<Member> members_;
+};
+
+}
+
+#pragma pack(pop)
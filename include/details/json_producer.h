@@ -0,0 +1,70 @@
+// json_producer.h
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Array field which items are produced one by one while the object is written,
+so a large array is streamed into the output without the vector of all the items.
+The producer is a function returning false after the last item, or an iterator range.
+Each write calls a copy of the producer: a range or a function with its own state gives the same items every time,
+a function reading a database cursor gives the items once only.
+Parsed and read arrays are kept in the vector and produced from it.
+//using data_type = std::tuple<std::string, Json::JsonExProducer<CRowType>>;
+//obj.set<AttrRows>(Json::JsonExProducer<CRowType>([&cursor](CRowType& row) { return cursor.next(row); }));
+//obj.set<AttrRows>(Json::JsonExProducer<CRowType>(rows.begin(), rows.end()));
+*/
+template<typename T> class JsonExProducer
+{
+public:
+	typedef T value_type;
+	// fills the next item, returns false if there are no more items
+	typedef std::function<bool(T&)> producer_type;
+
+public:
+	JsonExProducer() = default;
+	explicit JsonExProducer(producer_type producer): producer_(std::move(producer)) {}
+	template<typename It> JsonExProducer(It begin, It end): producer_(RangeProducer<It>(begin, end)) {}
+	explicit JsonExProducer(std::vector<T>&& items)
+	{
+		std::shared_ptr<const std::vector<T>> shared = std::make_shared<std::vector<T>>(std::move(items));
+		producer_ = RangeProducer<typename std::vector<T>::const_iterator, std::shared_ptr<const std::vector<T>>>(shared->begin(), shared->end(), shared);
+	}
+
+	// returns false if there is no producer, such a field is written as an empty array
+	explicit operator bool() const { return static_cast<bool>(producer_); }
+	const producer_type& producer() const { return producer_; }
+
+private:
+	// copies the items of the range, the optional owner keeps the range's container alive
+	template<typename It, typename Owner = std::nullptr_t> struct RangeProducer
+	{
+		RangeProducer(It begin, It end, Owner owner = Owner()): it_(begin), end_(end), owner_(std::move(owner)) {}
+		bool operator()(T& item)
+		{
+			if (it_ == end_) return false;
+			item = *it_;
+			++it_;
+			return true;
+		}
+
+		It it_;
+		It end_;
+		Owner owner_;
+	};
+
+private:
+	producer_type producer_;
+};
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,791 @@
+// json_reader.h
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <locale>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <json/json.h>
+
+#include "json_escape.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Json number as it is written in json text.
+Integer numbers are kept as integers, so the type checks give the same results as Json::Value ones.
+*/
+struct JsonExNumber
+{
+	enum number_type { intNumber, uintNumber, realNumber };
+
+	number_type type = uintNumber;
+	Json::LargestInt i = 0;
+	Json::LargestUInt u = 0;
+	double d = 0.0;
+
+	bool isInt() const
+	{
+		switch (type)
+		{
+		case intNumber: return i >= Json::Value::minInt && i <= Json::Value::maxInt;
+		case uintNumber: return u <= static_cast<Json::LargestUInt>(Json::Value::maxInt);
+		default: return d >= Json::Value::minInt && d <= Json::Value::maxInt && isIntegral(d);
+		}
+	}
+	bool isUInt() const
+	{
+		switch (type)
+		{
+		case intNumber: return i >= 0 && i <= static_cast<Json::LargestInt>(Json::Value::maxUInt);
+		case uintNumber: return u <= Json::Value::maxUInt;
+		default: return d >= 0 && d <= Json::Value::maxUInt && isIntegral(d);
+		}
+	}
+	bool isInt64() const
+	{
+		switch (type)
+		{
+		case intNumber: return true;
+		case uintNumber: return u <= static_cast<Json::LargestUInt>(Json::Value::maxInt64);
+		default: return d >= static_cast<double>(Json::Value::minInt64) && d < static_cast<double>(Json::Value::maxInt64) && isIntegral(d);
+		}
+	}
+	bool isUInt64() const
+	{
+		switch (type)
+		{
+		case intNumber: return i >= 0;
+		case uintNumber: return true;
+		default: return d >= 0 && d < 18446744073709551616.0 && isIntegral(d);
+		}
+	}
+	// any number converts to double, the same as Json::Value does
+	bool isDouble() const { return true; }
+
+	Json::LargestInt asInt64() const
+	{
+		switch (type)
+		{
+		case intNumber: return i;
+		case uintNumber: return static_cast<Json::LargestInt>(u);
+		default: return static_cast<Json::LargestInt>(d);
+		}
+	}
+	Json::LargestUInt asUInt64() const
+	{
+		switch (type)
+		{
+		case intNumber: return static_cast<Json::LargestUInt>(i);
+		case uintNumber: return u;
+		default: return static_cast<Json::LargestUInt>(d);
+		}
+	}
+	double asDouble() const
+	{
+		switch (type)
+		{
+		case intNumber: return static_cast<double>(i);
+		case uintNumber: return static_cast<double>(u);
+		default: return d;
+		}
+	}
+
+	// the same Json::Value type as jsoncpp reader creates for the number
+	Json::Value asValue() const
+	{
+		switch (type)
+		{
+		case intNumber: return Json::Value(i);
+		case uintNumber: return u <= static_cast<Json::LargestUInt>(Json::Value::maxInt) ? Json::Value(static_cast<Json::LargestInt>(u)) : Json::Value(u);
+		default: return Json::Value(d);
+		}
+	}
+
+	// converts the number to the basic type
+	template<typename T> static T as(const JsonExNumber& number)
+	{
+		return std::is_floating_point<T>::value ? static_cast<T>(number.asDouble()) :
+			std::is_signed<T>::value ? static_cast<T>(number.asInt64()) : static_cast<T>(number.asUInt64());
+	}
+
+	static bool isIntegral(double v)
+	{
+		double integral = 0;
+		return std::modf(v, &integral) == 0.0;
+	}
+};
+
+// basic types read by JsonExReader::read() methods
+template<typename T> struct JsonExReadable: std::integral_constant<bool,
+	std::is_same<T, bool>::value || std::is_same<T, int>::value || std::is_same<T, unsigned int>::value ||
+	std::is_same<T, long long>::value || std::is_same<T, unsigned long long>::value ||
+	std::is_same<T, double>::value || std::is_same<T, std::string>::value>
+{
+};
+
+/*
+Json text reader working on the contiguous buffer.
+Accepts the same json text as jsoncpp reader with default settings: comments are allowed,
+root value can be of any type, the text after the root value is ignored.
+Numbers are lenient the same way: the digits after '-', '.', the exponent mark and its sign may be missing,
+so '-' is read as 0, '22.' as 22.0 and '1e' as 1.0. Numbers out of double range are errors.
+Unpaired low surrogates are decoded as code points, a high surrogate takes the next \u escape as its pair.
+Syntax errors are reported by std::invalid_argument exception with the position of the error.
+
+Objects and arrays are read by the loops:
+	if (reader.beginObject()) do { reader.readKey(key); ...read value...; } while (reader.nextMember());
+	if (reader.beginArray()) do { ...read value...; } while (reader.nextElement());
+*/
+class JsonExReader
+{
+public:
+	enum token_type { tokenEnd, tokenNull, tokenBool, tokenNumber, tokenString, tokenArray, tokenObject, tokenInvalid };
+
+	// maximum nesting depth of arrays and objects, the same as jsoncpp has
+	static const int maxDepth = 1000;
+
+public:
+	JsonExReader(const char* begin, const char* end): begin_(begin), end_(end), pos_(begin) {}
+
+	const char* begin() const { return begin_; }
+	const char* end() const { return end_; }
+	// current reading position
+	const char* position() const { return pos_; }
+	void setPosition(const char* pos) { pos_ = pos; }
+
+	// reading state, the text can be read again from the marked state after looking ahead
+	struct mark_type
+	{
+		const char* pos;
+		int depth;
+	};
+	mark_type mark() const { return mark_type{ pos_, depth_ }; }
+	void reset(const mark_type& m)
+	{
+		pos_ = m.pos;
+		depth_ = m.depth;
+	}
+
+	// skips white spaces and comments, returns type of the next value by its first character
+	token_type peek()
+	{
+		skipSpaces();
+		if (pos_ == end_) return tokenEnd;
+		switch (*pos_)
+		{
+		case 'n': return tokenNull;
+		case 't': case 'f': return tokenBool;
+		case '"': return tokenString;
+		case '[': return tokenArray;
+		case '{': return tokenObject;
+		case '-': case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': return tokenNumber;
+		default: return tokenInvalid;
+		}
+	}
+
+	void readNull()
+	{
+		skipSpaces();
+		if (!match("null", 4)) error("Syntax error: value, object or array expected.");
+	}
+
+	bool readBool()
+	{
+		skipSpaces();
+		if (match("true", 4)) return true;
+		if (!match("false", 5)) error("Syntax error: value, object or array expected.");
+		return false;
+	}
+
+	void readNumber(JsonExNumber& number);
+
+	// reads and decodes string value
+	void readString(std::string& s)
+	{
+		const char* b = nullptr;
+		const char* e = nullptr;
+		s.clear();
+		if (!readStringRaw(b, e))
+		{
+			s.assign(b, e - b);
+			return;
+		}
+		const char* invalid = utils::json_unescape(s, b, e);
+		if (invalid) error("Bad escape sequence in string", invalid);
+	}
+
+	// reads string value without decoding, returns range of the string content between the quotes.
+	// Returns true if the content contains escape sequences.
+	bool readStringRaw(const char*& b, const char*& e)
+	{
+		skipSpaces();
+		if (pos_ == end_ || *pos_ != '"') error("Syntax error: string expected.");
+		b = ++pos_;
+		bool bEscaped = false;
+		for (;;)
+		{
+			const char* p = utils::json_find_quote(pos_, end_);
+			if (p == end_) error("Missing '\"' at the end of the string", b - 1);
+			if (*p == '"')
+			{
+				e = p;
+				pos_ = p + 1;
+				return bEscaped;
+			}
+			bEscaped = true;
+			pos_ = p + 2;
+			if (pos_ > end_) error("Missing '\"' at the end of the string", b - 1);
+		}
+	}
+
+	// reads string value without copying if the string has no escape sequences,
+	// otherwise the string is decoded into the scratch string. Returns the range of the decoded content.
+	void readStringView(const char*& b, const char*& e, std::string& scratch)
+	{
+		if (!readStringRaw(b, e)) return;
+		scratch.clear();
+		const char* invalid = utils::json_unescape(scratch, b, e);
+		if (invalid) error("Bad escape sequence in string", invalid);
+		b = scratch.data();
+		e = b + scratch.size();
+	}
+
+	// object reading, returns false if the object is empty
+	bool beginObject()
+	{
+		skipSpaces();
+		if (pos_ == end_ || *pos_ != '{') error("Syntax error: object expected.");
+		++pos_;
+		enter();
+		skipSpaces();
+		if (pos_ != end_ && *pos_ == '}')
+		{
+			++pos_;
+			leave();
+			return false;
+		}
+		return true;
+	}
+
+	// reads member's key and the following colon
+	void readKey(std::string& key)
+	{
+		readString(key);
+		readColon();
+	}
+
+	// reads member's key without copying if the key has no escape sequences,
+	// otherwise the key is decoded into the scratch string
+	void readKey(const char*& b, const char*& e, std::string& scratch)
+	{
+		readStringView(b, e, scratch);
+		readColon();
+	}
+
+	// returns true if the next member follows, false if the object ends
+	bool nextMember()
+	{
+		skipSpaces();
+		if (pos_ != end_)
+		{
+			char c = *pos_++;
+			if (c == ',') return true;
+			if (c == '}')
+			{
+				leave();
+				return false;
+			}
+		}
+		error("Missing ',' or '}' in object declaration");
+		return false;
+	}
+
+	// array reading, returns false if the array is empty
+	bool beginArray()
+	{
+		skipSpaces();
+		if (pos_ == end_ || *pos_ != '[') error("Syntax error: array expected.");
+		++pos_;
+		enter();
+		skipSpaces();
+		if (pos_ != end_ && *pos_ == ']')
+		{
+			++pos_;
+			leave();
+			return false;
+		}
+		return true;
+	}
+
+	// returns true if the next element follows, false if the array ends
+	bool nextElement()
+	{
+		skipSpaces();
+		if (pos_ != end_)
+		{
+			char c = *pos_++;
+			if (c == ',') return true;
+			if (c == ']')
+			{
+				leave();
+				return false;
+			}
+		}
+		error("Missing ',' or ']' in array declaration");
+		return false;
+	}
+
+	// reads the value of basic type, returns false and does not move if the value has another json type
+	// or does not fit the type. The checks are the same as Json::Value::isXxx() methods do.
+	bool read(bool& value)
+	{
+		if (peek() != tokenBool) return false;
+		value = readBool();
+		return true;
+	}
+	bool read(int& value) { return readNumber(value, &JsonExNumber::isInt); }
+	bool read(unsigned int& value) { return readNumber(value, &JsonExNumber::isUInt); }
+	bool read(long long& value) { return readNumber(value, &JsonExNumber::isInt64); }
+	bool read(unsigned long long& value) { return readNumber(value, &JsonExNumber::isUInt64); }
+	bool read(double& value) { return readNumber(value, &JsonExNumber::isDouble); }
+	bool read(std::string& value)
+	{
+		if (peek() != tokenString) return false;
+		readString(value);
+		return true;
+	}
+
+	// skips white spaces and comments up to the end of the line, returns false if a value follows on the same line
+	bool skipLine()
+	{
+		while (pos_ != end_)
+		{
+			char c = *pos_;
+			if (c == '\n')
+			{
+				++pos_;
+				return true;
+			}
+			if (c == ' ' || c == '\t' || c == '\r') ++pos_;
+			else if (c == '/')
+			{
+				const char* start = pos_;
+				skipComment();
+				if (std::memchr(start, '\n', pos_ - start)) return true;
+			}
+			else return false;
+		}
+		return true;
+	}
+
+	// skips the next value without decoding it
+	void skipValue();
+
+	// appends the next value's text without white spaces and comments, strings and numbers are copied as they are
+	void copyValue(std::string& s);
+
+	// reads the next value into json object
+	void readValue(Json::Value& value);
+
+	// throws exception with the position of the error
+	void error(const std::string& message) const { error(message, pos_); }
+	void error(const std::string& message, const char* pos) const;
+
+private:
+	template<typename T> bool readNumber(T& value, bool (JsonExNumber::*check)() const)
+	{
+		if (peek() != tokenNumber) return false;
+		const char* start = pos_;
+		JsonExNumber number;
+		readNumber(number);
+		if (!(number.*check)())
+		{
+			pos_ = start;
+			return false;
+		}
+		value = JsonExNumber::as<T>(number);
+		return true;
+	}
+
+	void skipSpaces()
+	{
+		while (pos_ != end_)
+		{
+			char c = *pos_;
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') ++pos_;
+			else if (c == '/') skipComment();
+			else break;
+		}
+	}
+
+	void skipComment()
+	{
+		const char* start = pos_;
+		if (end_ - pos_ >= 2 && pos_[1] == '/')
+		{
+			const char* p = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+			pos_ = p ? p + 1 : end_;
+			return;
+		}
+		if (end_ - pos_ >= 2 && pos_[1] == '*')
+		{
+			for (const char* p = pos_ + 2; end_ - p >= 2; p++)
+			{
+				if (p[0] == '*' && p[1] == '/')
+				{
+					pos_ = p + 2;
+					return;
+				}
+			}
+		}
+		error("Syntax error: value, object or array expected.", start);
+	}
+
+	bool match(const char* literal, size_t len)
+	{
+		if (static_cast<size_t>(end_ - pos_) < len || std::memcmp(pos_, literal, len) != 0) return false;
+		pos_ += len;
+		return true;
+	}
+
+	void readColon()
+	{
+		skipSpaces();
+		if (pos_ == end_ || *pos_ != ':') error("Missing ':' after object member name");
+		++pos_;
+	}
+
+	void enter()
+	{
+		if (++depth_ > maxDepth) error("Exceeded stackLimit in readValue().");
+	}
+	void leave() { --depth_; }
+
+	// finds the end of the number, the same chars as jsoncpp reader takes for the number.
+	// bReal is set if the number has a fraction or an exponent.
+	const char* scanNumber(const char* start, bool& bReal) const;
+	static double parseDouble(const char* b, const char* e);
+
+private:
+	const char* begin_;
+	const char* end_;
+	const char* pos_;
+	int depth_ = 0;
+};
+
+inline void JsonExReader::error(const std::string& message, const char* pos) const
+{
+	int line = 1;
+	const char* lineStart = begin_;
+	for (const char* p = begin_; p < pos && p < end_; p++)
+	{
+		if (*p == '\n')
+		{
+			line++;
+			lineStart = p + 1;
+		}
+	}
+	throw std::invalid_argument("* Line " + std::to_string(line) + ", Column " + std::to_string(pos - lineStart + 1) + "\n  " + message + "\n");
+}
+
+inline const char* JsonExReader::scanNumber(const char* start, bool& bReal) const
+{
+	const char* p = start;
+	if (p != end_ && *p == '-') p++;
+	while (p != end_ && *p >= '0' && *p <= '9') p++;
+	if (p == start) error("Syntax error: value, object or array expected.", start);
+
+	bReal = false;
+	if (p != end_ && *p == '.')
+	{
+		bReal = true;
+		for (p++; p != end_ && *p >= '0' && *p <= '9'; p++) {}
+	}
+	if (p != end_ && (*p == 'e' || *p == 'E'))
+	{
+		bReal = true;
+		p++;
+		if (p != end_ && (*p == '+' || *p == '-')) p++;
+		while (p != end_ && *p >= '0' && *p <= '9') p++;
+	}
+	return p;
+}
+
+inline void JsonExReader::readNumber(JsonExNumber& number)
+{
+	skipSpaces();
+	const char* start = pos_;
+	bool bReal = false;
+	const char* p = scanNumber(start, bReal);
+	pos_ = p;
+
+	bool bNegative = *start == '-';
+	Json::LargestUInt value = 0;
+	bool bOverflow = false;
+	if (!bReal)
+	{
+		for (const char* d = bNegative ? start + 1 : start; d != p; d++)
+		{
+			unsigned digit = static_cast<unsigned>(*d - '0');
+			if (value > (std::numeric_limits<Json::LargestUInt>::max() - digit) / 10) bOverflow = true;
+			value = value * 10 + digit;
+		}
+	}
+
+	// integers are kept as integers while they fit, the same as jsoncpp reader does
+	const Json::LargestUInt maxNegative = static_cast<Json::LargestUInt>(Json::Value::maxLargestInt) + 1;
+	if (!bReal && !bOverflow && (!bNegative || value <= maxNegative))
+	{
+		if (bNegative)
+		{
+			number.type = JsonExNumber::intNumber;
+			number.i = value == maxNegative ? Json::Value::minLargestInt : -static_cast<Json::LargestInt>(value);
+		}
+		else
+		{
+			number.type = JsonExNumber::uintNumber;
+			number.u = value;
+		}
+		return;
+	}
+	number.type = JsonExNumber::realNumber;
+	number.d = parseDouble(start, p);
+	if (std::isinf(number.d)) error("'" + std::string(start, p) + "' is not a number.", start);
+}
+
+inline double JsonExReader::parseDouble(const char* b, const char* e)
+{
+	// exact fast path: up to 15 significant digits and small decimal exponent
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const char* p = b;
+	bool bNegative = *p == '-';
+	if (bNegative) p++;
+	const char* first = p;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	for (; p != e && *p >= '0' && *p <= '9'; p++)
+	{
+		if (mantissa || *p != '0') digits++;
+		mantissa = mantissa * 10 + (*p - '0');
+	}
+	if (p != e && *p == '.')
+	{
+		for (p++; p != e && *p >= '0' && *p <= '9'; p++)
+		{
+			if (mantissa || *p != '0') digits++;
+			mantissa = mantissa * 10 + (*p - '0');
+			exponent--;
+		}
+	}
+	// a number without digits, such as '-e5', is not valid
+	if (p == first || (p - first == 1 && *first == '.')) return std::numeric_limits<double>::infinity();
+	if (p != e && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		bool bNegativeExp = p != e && *p == '-';
+		if (p != e && (*p == '+' || *p == '-')) p++;
+		int exp = 0;
+		for (; p != e && *p >= '0' && *p <= '9'; p++)
+		{
+			if (exp < 100000) exp = exp * 10 + (*p - '0');
+		}
+		exponent += bNegativeExp ? -exp : exp;
+	}
+	if (digits <= 15 && exponent >= -22 && exponent <= 22)
+	{
+		double v = static_cast<double>(mantissa);
+		v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+		return bNegative ? -v : v;
+	}
+
+	// other numbers are converted by the stream of the classic locale for correct rounding,
+	// the global locale may have another decimal point. The exponent mark without digits is dropped.
+	const char* mark = b;
+	while (mark != e && *mark != 'e' && *mark != 'E') mark++;
+	if (mark != e && (e[-1] < '0' || e[-1] > '9')) e = mark;
+	std::istringstream is(std::string(b, e));
+	is.imbue(std::locale::classic());
+	double value = 0;
+	if (!(is >> value)) return bNegative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+	return value;
+}
+
+inline void JsonExReader::skipValue()
+{
+	switch (peek())
+	{
+	case tokenNull: readNull(); break;
+	case tokenBool: readBool(); break;
+	case tokenNumber:
+		{
+			// the number's syntax is checked without conversion
+			bool bReal = false;
+			pos_ = scanNumber(pos_, bReal);
+		}
+		break;
+	case tokenString:
+		{
+			const char* b = nullptr;
+			const char* e = nullptr;
+			readStringRaw(b, e);
+		}
+		break;
+	case tokenArray:
+		if (beginArray()) do { skipValue(); } while (nextElement());
+		break;
+	case tokenObject:
+		if (beginObject())
+		{
+			do
+			{
+				const char* b = nullptr;
+				const char* e = nullptr;
+				readStringRaw(b, e);
+				readColon();
+				skipValue();
+			} while (nextMember());
+		}
+		break;
+	default:
+		error("Syntax error: value, object or array expected.");
+	}
+}
+
+inline void JsonExReader::copyValue(std::string& s)
+{
+	const char* b = nullptr;
+	const char* e = nullptr;
+	switch (peek())
+	{
+	case tokenNull:
+		readNull();
+		s.append("null", 4);
+		break;
+	case tokenBool:
+		if (readBool()) s.append("true", 4);
+		else s.append("false", 5);
+		break;
+	case tokenNumber:
+		{
+			bool bReal = false;
+			b = pos_;
+			pos_ = scanNumber(pos_, bReal);
+			s.append(b, pos_ - b);
+		}
+		break;
+	case tokenString:
+		readStringRaw(b, e);
+		s.append(b - 1, e - b + 2);
+		break;
+	case tokenArray:
+		s.push_back('[');
+		if (beginArray())
+		{
+			do
+			{
+				copyValue(s);
+				s.push_back(',');
+			} while (nextElement());
+			s.back() = ']';
+		}
+		else s.push_back(']');
+		break;
+	case tokenObject:
+		s.push_back('{');
+		if (beginObject())
+		{
+			do
+			{
+				readStringRaw(b, e);
+				readColon();
+				s.append(b - 1, e - b + 2);
+				s.push_back(':');
+				copyValue(s);
+				s.push_back(',');
+			} while (nextMember());
+			s.back() = '}';
+		}
+		else s.push_back('}');
+		break;
+	default:
+		error("Syntax error: value, object or array expected.");
+	}
+}
+
+inline void JsonExReader::readValue(Json::Value& value)
+{
+	switch (peek())
+	{
+	case tokenNull:
+		readNull();
+		value = Json::Value();
+		break;
+	case tokenBool:
+		value = Json::Value(readBool());
+		break;
+	case tokenNumber:
+		{
+			JsonExNumber number;
+			readNumber(number);
+			value = number.asValue();
+		}
+		break;
+	case tokenString:
+		{
+			const char* b = nullptr;
+			const char* e = nullptr;
+			if (!readStringRaw(b, e))
+			{
+				value = Json::Value(b, e);
+			}
+			else
+			{
+				std::string s;
+				const char* invalid = utils::json_unescape(s, b, e);
+				if (invalid) error("Bad escape sequence in string", invalid);
+				value = Json::Value(s);
+			}
+		}
+		break;
+	case tokenArray:
+		value = Json::Value(Json::arrayValue);
+		if (beginArray())
+		{
+			do
+			{
+				readValue(value[value.size()]);
+			} while (nextElement());
+		}
+		break;
+	case tokenObject:
+		value = Json::Value(Json::objectValue);
+		if (beginObject())
+		{
+			std::string key;
+			do
+			{
+				readKey(key);
+				readValue(value[key]);
+			} while (nextMember());
+		}
+		break;
+	default:
+		error("Syntax error: value, object or array expected.");
+	}
+}
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,132 @@
+// json_shared.h
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+#include "flat_map.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Immutable value shared by copies of the field: copying the field copies the pointer only, and the value is copied
+on the first change through modify() while other fields share it. The value keeps the json text it was read from,
+so reading the same text again into the field prepared from the previous object keeps the previous value
+instead of reading it, and unchanged parts of a reloaded config stay shared with the previous snapshot.
+Vectors and string maps of shared values compare their items by the index and by the key.
+Empty field is written as null.
+//Json::JsonExShared<CLimitsType> limits;
+//if (limits) maxSize = limits->maxSize;
+//limits.modify().maxSize = 10; // copies the value if another snapshot shares it
+*/
+template<typename T> class JsonExShared
+{
+public:
+	typedef T value_type;
+
+public:
+	JsonExShared() = default;
+	JsonExShared(std::nullptr_t) {}
+	JsonExShared(const T& value): node_(std::make_shared<Node>(value)) {}
+	JsonExShared(T&& value): node_(std::make_shared<Node>(std::move(value))) {}
+
+	bool empty() const { return !node_; }
+	explicit operator bool() const { return !!node_; }
+	bool operator!() const { return !node_; }
+
+	// returns the shared value, throws std::logic_error if the field is empty
+	const T& get() const
+	{
+		if (!node_) throw std::logic_error("JsonExShared is empty");
+		return node_->value;
+	}
+	const T& operator*() const { return get(); }
+	const T* operator->() const { return &get(); }
+
+	// pointer keeping the value alive after the field is changed or destroyed
+	std::shared_ptr<const T> pointer() const { return node_ ? std::shared_ptr<const T>(node_, &node_->value) : std::shared_ptr<const T>(); }
+
+	// returns the value for changing, the value is copied first if it is shared, an empty field gets the default value.
+	// The field must not be copied by other threads meanwhile.
+	T& modify()
+	{
+		if (!node_) node_ = std::make_shared<Node>(T());
+		else if (node_.use_count() > 1) node_ = std::make_shared<Node>(static_cast<const T&>(node_->value));
+		// the value does not match its text anymore
+		node_->text.clear();
+		return node_->value;
+	}
+
+	void reset() { node_.reset(); }
+
+	// count of the fields sharing the value
+	long use_count() const { return node_.use_count(); }
+	// returns true if both fields share the same value
+	bool shares(const JsonExShared& other) const { return node_ == other.node_; }
+
+	// returns true if the value was read from exactly the same json text
+	bool matches(const char* s, size_t len) const
+	{
+		return node_ && node_->text.size() == len && len && std::memcmp(node_->text.data(), s, len) == 0;
+	}
+
+	// sets the new value read from the json text
+	void assign(T&& value, const char* s, size_t len)
+	{
+		node_ = std::make_shared<Node>(std::move(value));
+		node_->text.assign(s, len);
+	}
+
+private:
+	struct Node
+	{
+		explicit Node(const T& v): value(v) {}
+		explicit Node(T&& v): value(std::move(v)) {}
+
+		T value;
+		// json text of the value, empty if the value was not read from json text
+		std::string text;
+	};
+
+	std::shared_ptr<Node> node_;
+};
+
+// true for JsonExShared fields and containers of them, such fields are copied from the previous object before reading
+template<typename T> struct JsonExHoldsShared: std::false_type
+{
+};
+
+template<typename T> struct JsonExHoldsShared<JsonExShared<T>>: std::true_type
+{
+};
+
+template<typename T> struct JsonExHoldsShared<std::vector<JsonExShared<T>>>: std::true_type
+{
+};
+
+template<typename T, typename C, typename A> struct JsonExHoldsShared<std::map<std::string, JsonExShared<T>, C, A>>: std::true_type
+{
+};
+
+template<typename T, typename H, typename E, typename A> struct JsonExHoldsShared<std::unordered_map<std::string, JsonExShared<T>, H, E, A>>: std::true_type
+{
+};
+
+template<typename T, typename C> struct JsonExHoldsShared<utils::FlatMap<std::string, JsonExShared<T>, C>>: std::true_type
+{
+};
+
+}
+
+#pragma pack(pop)
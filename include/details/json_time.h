@@ -0,0 +1,209 @@
+// json_time.h
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <chrono>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+// size of the buffer for json_time_format(): 9999-12-31T23:59:59.999999999Z
+static const size_t json_time_size = 32;
+
+// days since 1970-01-01 of the proleptic Gregorian calendar date
+inline long long json_days_from_civil(long long y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	long long era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = static_cast<unsigned>(y - era * 400);
+	unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+// proleptic Gregorian calendar date of the days since 1970-01-01
+inline void json_civil_from_days(long long z, long long& y, unsigned& m, unsigned& d)
+{
+	z += 719468;
+	long long era = (z >= 0 ? z : z - 146096) / 146097;
+	unsigned doe = static_cast<unsigned>(z - era * 146097);
+	unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	unsigned mp = (5 * doy + 2) / 153;
+	d = doy - (153 * mp + 2) / 5 + 1;
+	m = mp < 10 ? mp + 3 : mp - 9;
+	y = static_cast<long long>(yoe) + era * 400 + (m <= 2);
+}
+
+namespace json_time_details
+{
+
+inline bool digits(const char*& p, const char* e, size_t count, unsigned& value)
+{
+	if (static_cast<size_t>(e - p) < count) return false;
+	value = 0;
+	for (size_t i = 0; i < count; i++, p++)
+	{
+		if (*p < '0' || *p > '9') return false;
+		value = value * 10 + static_cast<unsigned>(*p - '0');
+	}
+	return true;
+}
+
+inline bool match(const char*& p, const char* e, char c)
+{
+	if (p == e || *p != c) return false;
+	p++;
+	return true;
+}
+
+inline char* put(char* out, unsigned value, size_t count)
+{
+	for (size_t i = count; i > 0; i--)
+	{
+		out[i - 1] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+	return out + count;
+}
+
+}
+
+/*
+Parses RFC 3339 date-time into seconds since 1970-01-01T00:00:00Z and nanoseconds of the second.
+The time zone is required: 2024-05-01T12:30:45.5Z, 2024-05-01T15:30:45+03:00.
+Fraction digits after the 9th are ignored. Returns false if the text is not valid date-time.
+*/
+inline bool json_time_parse(const char* b, const char* e, long long& seconds, long& nanos)
+{
+	using namespace json_time_details;
+	const char* p = b;
+	unsigned year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+	if (!digits(p, e, 4, year) || !match(p, e, '-') || !digits(p, e, 2, month) || !match(p, e, '-') || !digits(p, e, 2, day)) return false;
+	if (p == e || (*p != 'T' && *p != 't' && *p != ' ')) return false;
+	p++;
+	if (!digits(p, e, 2, hour) || !match(p, e, ':') || !digits(p, e, 2, minute) || !match(p, e, ':') || !digits(p, e, 2, second)) return false;
+
+	static const unsigned monthDays[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	bool bLeap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1] || (month == 2 && day == 29 && !bLeap)) return false;
+	// the leap second is accepted as the first second of the next minute
+	if (hour > 23 || minute > 59 || second > 60) return false;
+
+	long fraction = 0;
+	if (p != e && *p == '.')
+	{
+		const char* f = ++p;
+		long scale = 100000000;
+		for (; p != e && *p >= '0' && *p <= '9'; p++)
+		{
+			fraction += (*p - '0') * scale;
+			scale /= 10;
+		}
+		if (p == f) return false;
+	}
+
+	long long offset = 0;
+	if (p != e && (*p == 'Z' || *p == 'z'))
+	{
+		p++;
+	}
+	else if (p != e && (*p == '+' || *p == '-'))
+	{
+		long long sign = *p++ == '-' ? -1 : 1;
+		unsigned offsetHour = 0, offsetMinute = 0;
+		if (!digits(p, e, 2, offsetHour) || !match(p, e, ':') || !digits(p, e, 2, offsetMinute)) return false;
+		if (offsetHour > 23 || offsetMinute > 59) return false;
+		offset = sign * static_cast<long long>(offsetHour * 3600 + offsetMinute * 60);
+	}
+	else
+	{
+		return false;
+	}
+	if (p != e) return false;
+
+	seconds = json_days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset;
+	nanos = fraction;
+	return true;
+}
+
+/*
+Writes RFC 3339 UTC date-time of the seconds since 1970-01-01T00:00:00Z and nanoseconds of the second.
+The fraction is written by 3, 6 or 9 digits if it is not zero. The buffer must have json_time_size chars at least.
+Returns the length of the text, or 0 if the year is out of 0000-9999.
+*/
+inline size_t json_time_format(char* out, long long seconds, long nanos)
+{
+	using namespace json_time_details;
+	long long days = seconds >= 0 ? seconds / 86400 : -((-seconds + 86399) / 86400);
+	unsigned secondOfDay = static_cast<unsigned>(seconds - days * 86400);
+	long long year = 0;
+	unsigned month = 0, day = 0;
+	json_civil_from_days(days, year, month, day);
+	if (year < 0 || year > 9999 || nanos < 0 || nanos > 999999999) return 0;
+
+	char* p = put(out, static_cast<unsigned>(year), 4);
+	*p++ = '-';
+	p = put(p, month, 2);
+	*p++ = '-';
+	p = put(p, day, 2);
+	*p++ = 'T';
+	p = put(p, secondOfDay / 3600, 2);
+	*p++ = ':';
+	p = put(p, secondOfDay / 60 % 60, 2);
+	*p++ = ':';
+	p = put(p, secondOfDay % 60, 2);
+	if (nanos)
+	{
+		*p++ = '.';
+		unsigned n = static_cast<unsigned>(nanos);
+		if (n % 1000000 == 0) p = put(p, n / 1000000, 3);
+		else if (n % 1000 == 0) p = put(p, n / 1000, 6);
+		else p = put(p, n, 9);
+	}
+	*p++ = 'Z';
+	return static_cast<size_t>(p - out);
+}
+
+// splits epoch number of seconds with the fraction, returns false if the number is out of range
+inline bool json_time_from_epoch(double value, long long& seconds, long& nanos)
+{
+	if (!(value > -1e15 && value < 1e15)) return false;
+	double whole = std::floor(value);
+	seconds = static_cast<long long>(whole);
+	nanos = static_cast<long>(std::floor((value - whole) * 1e9 + 0.5));
+	if (nanos >= 1000000000)
+	{
+		seconds++;
+		nanos -= 1000000000;
+	}
+	return true;
+}
+
+// splits the time point into seconds since the clock's epoch and nanoseconds, rounded down
+template<typename Clock, typename D>
+inline void json_time_split(const std::chrono::time_point<Clock, D>& tp, long long& seconds, long& nanos)
+{
+	D d = tp.time_since_epoch();
+	std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>(d);
+	if (s > d) s -= std::chrono::seconds(1);
+	seconds = static_cast<long long>(s.count());
+	nanos = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(d - s).count());
+}
+
+// makes the time point of seconds since the clock's epoch and nanoseconds, returns false if the time does not fit the type
+template<typename Clock, typename D>
+inline bool json_time_make(long long seconds, long nanos, std::chrono::time_point<Clock, D>& tp)
+{
+	double limit = std::chrono::duration<double>(D::max()).count();
+	if (static_cast<double>(seconds) >= limit - 1 || static_cast<double>(seconds) <= -limit + 1) return false;
+	tp = std::chrono::time_point<Clock, D>(std::chrono::duration_cast<D>(std::chrono::seconds(seconds)) + std::chrono::duration_cast<D>(std::chrono::nanoseconds(nanos)));
+	return true;
+}
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,219 @@
+// json_variant.h
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+#include "tuple_utils.h"
+#include "json_enum.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+class JsonExBase;
+template<typename _ImplT> struct JsonExDataTraits;
+// sets and checks the discriminator field of the alternative, defined by jsonex.h
+template<typename K, typename T> struct JsonExVariantKey;
+
+// index of the type in the list of the types, the size of the list if there is no such type
+template<typename T, typename... Ts> struct JsonExVariantIndex;
+
+template<typename T> struct JsonExVariantIndex<T>: std::integral_constant<size_t, 0>
+{
+};
+
+template<typename T, typename U, typename... Ts> struct JsonExVariantIndex<T, U, Ts...>:
+	std::integral_constant<size_t, std::is_same<T, U>::value ? 0 : 1 + JsonExVariantIndex<T, Ts...>::value>
+{
+};
+
+// maximal value of the values
+template<size_t V, size_t... Vs> struct JsonExVariantMax: std::integral_constant<size_t, V>
+{
+};
+
+template<size_t V, size_t U, size_t... Vs> struct JsonExVariantMax<V, U, Vs...>: JsonExVariantMax<(V > U ? V : U), Vs...>
+{
+};
+
+/*
+Field holding one of JsonEx based types, selected by the discriminator member of json object.
+The member's name is given by the key type, each alternative names its discriminator value in its data traits
+and has the discriminator as its own string field, so the member is written by the alternative itself.
+The field is set when the alternative is created by emplace(), and writing fails if the field is changed to another value.
+Reading looks ahead for the discriminator at the token level and decodes the object once by the selected type.
+The alternative is found by the perfect hash of the discriminator values. Empty variant is written as null.
+//struct CEventKey { static const char* name() { return "type"; } };
+//template<> struct Json::JsonExDataTraits<CClickEvent>
+//{
+//	...
+//	static const char* discriminator() { return "click"; }
+//};
+//using CEvent = Json::JsonExVariant<CEventKey, CClickEvent, CKeyEvent>;
+//if (event.is<CClickEvent>()) handleClick(event.get<CClickEvent>());
+*/
+template<typename K, typename... Ts> class JsonExVariant
+{
+	static_assert(sizeof...(Ts) > 0, "JsonExVariant must have alternatives");
+
+public:
+	// index of the empty variant
+	static const size_t npos = static_cast<size_t>(-1);
+
+public:
+	JsonExVariant() = default;
+	template<typename T, typename std::enable_if<JsonExVariantIndex<typename std::decay<T>::type, Ts...>::value < sizeof...(Ts)>::type * = nullptr>
+	JsonExVariant(T&& value) { emplace<typename std::decay<T>::type>(std::forward<T>(value)); }
+	JsonExVariant(const JsonExVariant& other) { copyFrom(other); }
+	JsonExVariant(JsonExVariant&& other) { moveFrom(other); }
+	~JsonExVariant() { reset(); }
+
+	JsonExVariant& operator=(const JsonExVariant& other)
+	{
+		if (this != &other)
+		{
+			reset();
+			copyFrom(other);
+		}
+		return *this;
+	}
+	JsonExVariant& operator=(JsonExVariant&& other)
+	{
+		if (this != &other)
+		{
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	// index of the held type in the alternatives, npos if the variant is empty
+	size_t index() const { return index_; }
+	bool empty() const { return index_ == npos; }
+	template<typename T> bool is() const { return index_ == JsonExVariantIndex<T, Ts...>::value; }
+
+	// returns the held object, throws std::logic_error if the variant holds another type
+	template<typename T> T& get()
+	{
+		if (!is<T>()) throw std::logic_error("JsonExVariant holds another type");
+		return *reinterpret_cast<T*>(&storage_);
+	}
+	template<typename T> const T& get() const
+	{
+		if (!is<T>()) throw std::logic_error("JsonExVariant holds another type");
+		return *reinterpret_cast<const T*>(&storage_);
+	}
+	// returns the held object, nullptr if the variant holds another type
+	template<typename T> T* get_if() { return is<T>() ? reinterpret_cast<T*>(&storage_) : nullptr; }
+	template<typename T> const T* get_if() const { return is<T>() ? reinterpret_cast<const T*>(&storage_) : nullptr; }
+
+	// the held object as JsonExBase, nullptr if the variant is empty
+	JsonExBase* base() { return empty() ? nullptr : table().base[index_](&storage_); }
+	const JsonExBase* base() const { return empty() ? nullptr : table().base[index_](const_cast<storage_type*>(&storage_)); }
+
+	template<typename T, typename... Args> T& emplace(Args&&... args)
+	{
+		static_assert(JsonExVariantIndex<T, Ts...>::value < sizeof...(Ts), "The type is not the variant's alternative");
+		reset();
+		T* obj = new (&storage_) T(std::forward<Args>(args)...);
+		index_ = JsonExVariantIndex<T, Ts...>::value;
+		Stamp<T>(obj);
+		return *obj;
+	}
+
+	void reset()
+	{
+		if (empty()) return;
+		table().destroy[index_](&storage_);
+		index_ = npos;
+	}
+
+	// member name of the discriminator
+	static const char* key() { return K::name(); }
+	// discriminator value of the alternative
+	static const char* discriminator(size_t index) { return table().discriminator[index]; }
+	// returns the index of the alternative by the discriminator value, npos if there is no such alternative
+	static size_t find(const char* s, size_t len)
+	{
+		alternative_enum value;
+		return names().find(s, len, value) ? static_cast<size_t>(value) : npos;
+	}
+
+	// creates the default object of the alternative
+	void emplaceIndex(size_t index)
+	{
+		reset();
+		table().construct[index](&storage_);
+		index_ = index;
+		table().stamp[index](&storage_);
+	}
+
+private:
+	typedef typename std::aligned_storage<JsonExVariantMax<sizeof(Ts)...>::value, JsonExVariantMax<std::alignment_of<Ts>::value...>::value>::type storage_type;
+	enum class alternative_enum : size_t {};
+
+	// methods of the alternatives by the index
+	struct Table
+	{
+		void (*construct[sizeof...(Ts)])(void*);
+		void (*copy[sizeof...(Ts)])(void*, const void*);
+		void (*move[sizeof...(Ts)])(void*, void*);
+		void (*destroy[sizeof...(Ts)])(void*);
+		void (*stamp[sizeof...(Ts)])(void*);
+		JsonExBase* (*base[sizeof...(Ts)])(void*);
+		const char* discriminator[sizeof...(Ts)];
+	};
+
+	template<typename T> static void Construct(void* p) { new (p) T(); }
+	template<typename T> static void Copy(void* p, const void* other) { new (p) T(*static_cast<const T*>(other)); }
+	template<typename T> static void Move(void* p, void* other) { new (p) T(std::move(*static_cast<T*>(other))); }
+	template<typename T> static void Destroy(void* p) { static_cast<T*>(p)->~T(); }
+	// sets the discriminator field to the alternative's value
+	template<typename T> static void Stamp(void* p) { JsonExVariantKey<K, T>::set(*static_cast<T*>(p), JsonExDataTraits<T>::discriminator()); }
+	template<typename T> static JsonExBase* Base(void* p) { return static_cast<T*>(p); }
+
+	static const Table& table()
+	{
+		static const Table t =
+		{
+			{ &Construct<Ts>... }, { &Copy<Ts>... }, { &Move<Ts>... }, { &Destroy<Ts>... }, { &Stamp<Ts>... }, { &Base<Ts>... },
+			{ JsonExDataTraits<Ts>::discriminator()... }
+		};
+		return t;
+	}
+
+	static const JsonExEnumNames<alternative_enum>& names() { return makeNames(utils::make_index_sequence<sizeof...(Ts)>()); }
+	template<size_t... I> static const JsonExEnumNames<alternative_enum>& makeNames(utils::index_sequence<I...>)
+	{
+		static const JsonExEnumNames<alternative_enum> n{ typename JsonExEnumNames<alternative_enum>::item_type(static_cast<alternative_enum>(I), JsonExDataTraits<Ts>::discriminator())... };
+		return n;
+	}
+
+	void copyFrom(const JsonExVariant& other)
+	{
+		if (other.empty()) return;
+		table().copy[other.index_](&storage_, &other.storage_);
+		index_ = other.index_;
+	}
+	void moveFrom(JsonExVariant& other)
+	{
+		if (other.empty()) return;
+		table().move[other.index_](&storage_, &other.storage_);
+		index_ = other.index_;
+	}
+
+private:
+	storage_type storage_;
+	size_t index_ = npos;
+};
+
+template<typename K, typename... Ts> const size_t JsonExVariant<K, Ts...>::npos;
+
+}
+
+#pragma pack(pop)
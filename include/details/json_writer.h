@@ -0,0 +1,284 @@
+// json_writer.h
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <functional>
+#include <vector>
+
+#include <json/json.h>
+
+#include "json_escape.h"
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+class ThreadPool;
+}
+
+namespace Json
+{
+
+// piece of the output, has the same members as POSIX struct iovec, so the segments can be passed to writev/sendmsg
+struct JsonExSegment
+{
+	const char* data;
+	size_t size;
+};
+
+/*
+Compact json text writer, appends the output to the string buffer.
+The output is the same as Json::StreamWriterBuilder with empty indentation produces,
+so json text written directly and through Json::Value is identical.
+With the sink set, the buffer is passed to the sink and cleared when it exceeds the chunk size
+between the items of arrays, so the buffer keeps about one chunk of the text only.
+With referencing set, long strings of the written objects are not copied into the buffer,
+the output is the list of segments of the buffer and of the objects' memory.
+*/
+class JsonExWriter
+{
+public:
+	// receives the written text by chunks
+	typedef std::function<void(const char*, size_t)> sink_type;
+
+	explicit JsonExWriter(std::string& buffer, utils::ThreadPool* pool = nullptr): buffer_(buffer), pool_(pool), shared_(false) {}
+
+	// minimal count of array's items written by one task of the pool
+	static const size_t parallelChunkSize = 1024;
+	// default size of the text passed to the sink at once
+	static const size_t sinkChunkSize = 64 * 1024;
+	// size of the text counted or copied to the fixed buffer at once, small enough to keep the buffer in the cache
+	static const size_t copyChunkSize = 4 * 1024;
+	// minimal size of the text referenced in place by the segments output
+	static const size_t referenceMinSize = 256;
+
+	// output buffer
+	std::string& buffer() { return buffer_; }
+	// optional pool for parallel writing of large arrays, the output is the same as sequential writing gives
+	utils::ThreadPool* pool() const { return pool_; }
+	// written objects may be written by other threads at the same time, so they must not be changed:
+	// the objects' caches are used while they are valid, but never updated
+	bool isShared() const { return shared_; }
+	void setShared(bool shared) { shared_ = shared; }
+
+	// the text is counted only, values which can be written once only (producers) fail the writing
+	bool isSizing() const { return sizing_; }
+	void setSizing(bool sizing) { sizing_ = sizing; }
+
+	// long strings and cached text of the written objects are referenced in place instead of copying, see segments().
+	// Must be reset while temporary values are written. The writer with the sink never references.
+	bool isReferencing() const { return referencing_; }
+	void setReferencing(bool referencing) { referencing_ = referencing; }
+	// returns the output as the segments of the buffer and the referenced memory.
+	// The segments are valid while the buffer and the written objects are not changed.
+	void segments(std::vector<JsonExSegment>& out) const
+	{
+		out.clear();
+		for (const Piece& piece: pieces_)
+		{
+			if (piece.size) out.push_back(JsonExSegment{ piece.data ? piece.data : buffer_.data() + piece.offset, piece.size });
+		}
+		if (buffer_.size() > offset_) out.push_back(JsonExSegment{ buffer_.data() + offset_, buffer_.size() - offset_ });
+	}
+
+	// sets the sink receiving the text by chunks. The writers of cached text never have the sink,
+	// as the cache keeps the positions of the fields in the buffer.
+	void setSink(sink_type sink, size_t chunkSize = sinkChunkSize)
+	{
+		sink_ = std::move(sink);
+		chunkSize_ = chunkSize;
+	}
+	// passes the buffer to the sink if the buffer exceeds the chunk size
+	void flushChunk()
+	{
+		if (sink_ && buffer_.size() >= chunkSize_) flush();
+	}
+	// passes the rest of the text to the sink, must be called after the last value is written
+	void flush()
+	{
+		if (!sink_ || buffer_.empty()) return;
+		sink_(buffer_.data(), buffer_.size());
+		buffer_.clear();
+	}
+
+	// append already formatted json text
+	void writeRaw(const char* s, size_t len) { buffer_.append(s, len); }
+	void writeRaw(const std::string& s) { buffer_.append(s); }
+	// append already formatted json text, which is kept unchanged until the output is used, so it may be referenced
+	void writeRawRef(const char* s, size_t len)
+	{
+		if (!referencing_ || sink_ || len < referenceMinSize) return writeRaw(s, len);
+		reference(s, len);
+	}
+	void writeChar(char c) { buffer_.push_back(c); }
+
+	void writeNull() { buffer_.append("null", 4); }
+	void writeBool(bool value) { value ? buffer_.append("true", 4) : buffer_.append("false", 5); }
+	void writeInt(Json::LargestInt value);
+	void writeUInt(Json::LargestUInt value);
+	void writeDouble(double value);
+	void writeString(const char* s, size_t len) { utils::json_quote(buffer_, s, len); }
+	void writeString(const std::string& s) { writeString(s.data(), s.size()); }
+	// writes the string, which is kept unchanged until the output is used, so it may be referenced if it has no chars to escape
+	void writeStringRef(const char* s, size_t len)
+	{
+		if (!referencing_ || sink_ || len < referenceMinSize || utils::json_find_escaped(s, s + len) != s + len) return writeString(s, len);
+		buffer_.push_back('"');
+		reference(s, len);
+		buffer_.push_back('"');
+	}
+
+	// basic types writing, the same json types as Json::Value constructors create
+	void write(bool value) { writeBool(value); }
+	void write(const std::string& value) { writeStringRef(value.data(), value.size()); }
+	template<typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type * = nullptr>
+	void write(T value) { writeInt(static_cast<Json::LargestInt>(value)); }
+	template<typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type * = nullptr>
+	void write(T value) { writeUInt(static_cast<Json::LargestUInt>(value)); }
+	template<typename T, typename std::enable_if<std::is_floating_point<T>::value>::type * = nullptr>
+	void write(T value) { writeDouble(static_cast<double>(value)); }
+
+	// write Json::Value tree
+	void writeValue(const Json::Value& value);
+
+private:
+	// segment of the buffer's text or of the referenced memory
+	struct Piece
+	{
+		const char* data;
+		size_t offset;
+		size_t size;
+	};
+
+	// ends the segment of the buffer and adds the segment of the referenced memory
+	void reference(const char* s, size_t len)
+	{
+		pieces_.push_back(Piece{ nullptr, offset_, buffer_.size() - offset_ });
+		pieces_.push_back(Piece{ s, 0, len });
+		offset_ = buffer_.size();
+	}
+
+private:
+	std::string& buffer_;
+	utils::ThreadPool* pool_;
+	bool shared_;
+	sink_type sink_;
+	size_t chunkSize_ = sinkChunkSize;
+	bool referencing_ = false;
+	bool sizing_ = false;
+	// segments before the current segment of the buffer, which starts at the offset
+	std::vector<Piece> pieces_;
+	size_t offset_ = 0;
+};
+
+inline void JsonExWriter::writeUInt(Json::LargestUInt value)
+{
+	char buf[24];
+	char* p = buf + sizeof(buf);
+	do
+	{
+		*--p = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	buffer_.append(p, buf + sizeof(buf) - p);
+}
+
+inline void JsonExWriter::writeInt(Json::LargestInt value)
+{
+	if (value < 0)
+	{
+		buffer_.push_back('-');
+		// negate in unsigned type, so the min value does not overflow
+		writeUInt(0 - static_cast<Json::LargestUInt>(value));
+	}
+	else
+	{
+		writeUInt(static_cast<Json::LargestUInt>(value));
+	}
+}
+
+inline void JsonExWriter::writeDouble(double value)
+{
+	// the same formatting as jsoncpp: 17 digits of precision, keep the decimal point
+	char buf[36];
+	int len = 0;
+	if (std::isfinite(value))
+	{
+		len = std::snprintf(buf, sizeof(buf), "%.17g", value);
+		bool bHasPoint = false;
+		for (int i = 0; i < len; i++)
+		{
+			// decimal point is locale dependent
+			if (buf[i] == ',') buf[i] = '.';
+			if (buf[i] == '.' || buf[i] == 'e') bHasPoint = true;
+		}
+		if (!bHasPoint)
+		{
+			buf[len++] = '.';
+			buf[len++] = '0';
+		}
+	}
+	else if (value != value)
+	{
+		len = std::snprintf(buf, sizeof(buf), "null");
+	}
+	else
+	{
+		len = std::snprintf(buf, sizeof(buf), value < 0 ? "-1e+9999" : "1e+9999");
+	}
+	buffer_.append(buf, len);
+}
+
+inline void JsonExWriter::writeValue(const Json::Value& value)
+{
+	switch (value.type())
+	{
+	case Json::nullValue: writeNull(); break;
+	case Json::intValue: writeInt(value.asLargestInt()); break;
+	case Json::uintValue: writeUInt(value.asLargestUInt()); break;
+	case Json::realValue: writeDouble(value.asDouble()); break;
+	case Json::booleanValue: writeBool(value.asBool()); break;
+	case Json::stringValue:
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+			if (value.getString(&begin, &end)) writeString(begin, end - begin);
+		}
+		break;
+	case Json::arrayValue:
+		{
+			writeChar('[');
+			for (Json::ArrayIndex i = 0; i < value.size(); i++)
+			{
+				if (i) writeChar(',');
+				writeValue(value[i]);
+			}
+			writeChar(']');
+		}
+		break;
+	case Json::objectValue:
+		{
+			// members are iterated in the sorted order, the same as Json::Value::getMemberNames() returns
+			writeChar('{');
+			for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+			{
+				if (it != value.begin()) writeChar(',');
+				const char* end = nullptr;
+				const char* name = it.memberName(&end);
+				writeString(name, end - name);
+				writeChar(':');
+				writeValue(*it);
+			}
+			writeChar('}');
+		}
+		break;
+	}
+}
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,212 @@
+// small_vector.h
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+/*
+Vector keeping up to N items inside the object, so short arrays need no heap allocation.
+With bGrow set, the items are moved to the heap when the vector grows over N (SmallVector),
+otherwise the capacity is fixed and growing over N throws std::length_error (BoundedVector).
+//SmallVector<int, 4> small{ 1, 2, 3 };
+//small.push_back(4); // no heap allocation
+//small.push_back(5); // moved to the heap
+//BoundedVector<int, 2> bounded{ 1, 2 };
+//bounded.push_back(3); // throws std::length_error
+*/
+template<typename T, size_t N, bool bGrow>
+class InlineVector
+{
+	static_assert(N > 0, "InlineVector must have inline capacity");
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	// maximal count of the items kept inside the object
+	static const size_t inline_capacity = N;
+
+public:
+	InlineVector() = default;
+	InlineVector(std::initializer_list<T> items) { assign(items.begin(), items.end()); }
+	InlineVector(const InlineVector& other) { assign(other.begin(), other.end()); }
+	InlineVector(InlineVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) { moveFrom(other); }
+	~InlineVector()
+	{
+		clear();
+		if (!isInline()) ::operator delete(data_);
+	}
+
+	InlineVector& operator=(const InlineVector& other)
+	{
+		if (this != &other) assign(other.begin(), other.end());
+		return *this;
+	}
+	InlineVector& operator=(InlineVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &other)
+		{
+			clear();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	iterator begin() { return data_; }
+	iterator end() { return data_ + size_; }
+	const_iterator begin() const { return data_; }
+	const_iterator end() const { return data_ + size_; }
+
+	T* data() { return data_; }
+	const T* data() const { return data_; }
+	bool empty() const { return size_ == 0; }
+	size_type size() const { return size_; }
+	size_type capacity() const { return capacity_; }
+	static size_type max_size() { return bGrow ? static_cast<size_type>(-1) / sizeof(T) : N; }
+	// returns true while the items are kept inside the object
+	bool isInline() const { return data_ == inlineData(); }
+
+	T& operator[](size_type i) { return data_[i]; }
+	const T& operator[](size_type i) const { return data_[i]; }
+	T& at(size_type i)
+	{
+		if (i >= size_) throw std::out_of_range("InlineVector index out of range");
+		return data_[i];
+	}
+	const T& at(size_type i) const
+	{
+		if (i >= size_) throw std::out_of_range("InlineVector index out of range");
+		return data_[i];
+	}
+	T& front() { return data_[0]; }
+	const T& front() const { return data_[0]; }
+	T& back() { return data_[size_ - 1]; }
+	const T& back() const { return data_[size_ - 1]; }
+
+	void clear()
+	{
+		for (size_type i = 0; i < size_; i++) data_[i].~T();
+		size_ = 0;
+	}
+
+	void reserve(size_type n)
+	{
+		if (n <= capacity_) return;
+		if (!bGrow) throw std::length_error("InlineVector capacity exceeded");
+		moveTo(static_cast<T*>(::operator new(n * sizeof(T))), n);
+	}
+
+	void resize(size_type n)
+	{
+		if (n > capacity_) reserve(n);
+		while (size_ > n) pop_back();
+		while (size_ < n) emplace_back();
+	}
+
+	template<typename... Args> T& emplace_back(Args&&... args)
+	{
+		if (size_ < capacity_)
+		{
+			new (data_ + size_) T(std::forward<Args>(args)...);
+			return data_[size_++];
+		}
+		if (!bGrow) throw std::length_error("InlineVector capacity exceeded");
+		// the new item is built before the items are moved, the arguments may refer to them: v.push_back(v[0])
+		size_type n = capacity_ * 2;
+		T* data = static_cast<T*>(::operator new(n * sizeof(T)));
+		try
+		{
+			new (data + size_) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			::operator delete(data);
+			throw;
+		}
+		moveTo(data, n);
+		return data_[size_++];
+	}
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+	void pop_back() { data_[--size_].~T(); }
+
+	template<typename It> void assign(It first, It last)
+	{
+		clear();
+		reserve(static_cast<size_type>(std::distance(first, last)));
+		for (; first != last; ++first) emplace_back(*first);
+	}
+
+	friend bool operator==(const InlineVector& op1, const InlineVector& op2)
+	{
+		return op1.size_ == op2.size_ && std::equal(op1.begin(), op1.end(), op2.begin());
+	}
+	friend bool operator!=(const InlineVector& op1, const InlineVector& op2) { return !(op1 == op2); }
+
+private:
+	T* inlineData() { return reinterpret_cast<T*>(&storage_); }
+	const T* inlineData() const { return reinterpret_cast<const T*>(&storage_); }
+
+	// moves the items into the new storage of n items and frees the current one
+	void moveTo(T* data, size_type n)
+	{
+		for (size_type i = 0; i < size_; i++)
+		{
+			new (data + i) T(std::move(data_[i]));
+			data_[i].~T();
+		}
+		if (!isInline()) ::operator delete(data_);
+		data_ = data;
+		capacity_ = n;
+	}
+
+	// takes the heap items, or moves inline items one by one. The other vector is left empty.
+	void moveFrom(InlineVector& other)
+	{
+		if (!other.isInline())
+		{
+			if (!isInline()) ::operator delete(data_);
+			data_ = other.data_;
+			size_ = other.size_;
+			capacity_ = other.capacity_;
+			other.data_ = other.inlineData();
+			other.size_ = 0;
+			other.capacity_ = N;
+			return;
+		}
+		reserve(other.size_);
+		for (size_type i = 0; i < other.size_; i++) new (data_ + i) T(std::move(other.data_[i]));
+		size_ = other.size_;
+		other.clear();
+	}
+
+private:
+	typename std::aligned_storage<sizeof(T) * N, std::alignment_of<T>::value>::type storage_;
+	T* data_ = inlineData();
+	size_type size_ = 0;
+	size_type capacity_ = N;
+};
+
+// vector with N inline items, moved to the heap when it grows over N
+template<typename T, size_t N> using SmallVector = InlineVector<T, N, true>;
+// vector of at most N inline items, never allocates
+template<typename T, size_t N> using BoundedVector = InlineVector<T, N, false>;
+
+}
+
+#pragma pack(pop)
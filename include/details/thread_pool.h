@@ -0,0 +1,133 @@
+// thread_pool.h
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+#pragma pack(push, 8)
+
+namespace utils
+{
+
+/*
+Fixed count of worker threads executing posted tasks in the posting order.
+//ThreadPool pool(4);
+//std::vector<int> squares(100);
+//pool.parallel_for(squares.size(), [&squares](size_t i) { squares[i] = static_cast<int>(i * i); });
+*/
+class ThreadPool
+{
+public:
+	// creates the pool with the threads count, by default one thread per hardware core
+	explicit ThreadPool(size_t threads = 0)
+	{
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+		threads_.reserve(threads);
+		for (size_t i = 0; i < threads; i++) threads_.emplace_back(&ThreadPool::work, this);
+	}
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		for (std::thread& t: threads_) t.join();
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// count of the worker threads
+	size_t size() const { return threads_.size(); }
+
+	// runs the task on a worker thread
+	void post(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.push_back(std::move(task));
+		}
+		cv_.notify_one();
+	}
+
+	// runs fn(0) ... fn(count - 1) on the worker threads and the calling thread, returns when all the calls are done.
+	// The first exception thrown by fn is rethrown. Must not be called from the pool's tasks.
+	void parallel_for(size_t count, const std::function<void(size_t)>& fn)
+	{
+		std::atomic<size_t> next(0);
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable cv;
+		size_t finished = 0;
+
+		auto run = [&]()
+		{
+			for (;;)
+			{
+				size_t i = next++;
+				if (i >= count) break;
+				try
+				{
+					fn(i);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error) error = std::current_exception();
+				}
+			}
+		};
+
+		size_t helpers = count > 1 ? std::min(size(), count - 1) : 0;
+		for (size_t i = 0; i < helpers; i++)
+		{
+			post([&]()
+			{
+				run();
+				std::lock_guard<std::mutex> lock(mutex);
+				++finished;
+				cv.notify_one();
+			});
+		}
+		run();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [&]() { return finished == helpers; });
+		if (error) std::rethrow_exception(error);
+	}
+
+private:
+	void work()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+				if (tasks_.empty()) return;
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+			task();
+		}
+	}
+
+private:
+	std::vector<std::thread> threads_;
+	std::deque<std::function<void()>> tasks_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	bool stop_ = false;
+};
+
+}
+
+#pragma pack(pop)
@@ -84,6 +84,34 @@ template<typename TupleType, typename FunctionType> size_t find_if(TupleType&& t
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// compile time sequence of indexes, the same as C++14 std::index_sequence
+template<size_t... I> struct index_sequence
+{
+	static constexpr size_t size() { return sizeof...(I); }
+};
+
+template<size_t N, size_t... I> struct make_index_sequence_helper: make_index_sequence_helper<N - 1, N - 1, I...>
+{
+};
+
+template<size_t... I> struct make_index_sequence_helper<0, I...>
+{
+	typedef index_sequence<I...> type;
+};
+
+/*
+Using index sequence to build an array from tuple's items:
+//template<typename TupleType, size_t... I> std::array<size_t, sizeof...(I)> sizes(const TupleType& t, index_sequence<I...>)
+//{
+//	return {{ sizeof(std::get<I>(t))... }};
+//}
+//auto t = std::make_tuple(1, 2.0, 'c');
+//auto a = sizes(t, make_index_sequence<std::tuple_size<decltype(t)>::value>());
+*/
+template<size_t N> using make_index_sequence = typename make_index_sequence_helper<N>::type;
+
+///////////////////////////////////////////////////////////////////////////////
+
 }
 
 #pragma pack(pop)
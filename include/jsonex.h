@@ -5,6 +5,7 @@
 //#pragma warning(disable:4503) // decorated name length exceeded, name was truncated
 
 #include <string>
+#include <cstring>
 #include <memory>
 #include <istream>
 #include <ostream>
@@ -12,28 +13,67 @@
 #include <tuple>
 #include <vector>
 #include <array>
+#include <map>
+#include <unordered_map>
 #include <stdexcept>
 #include <functional>
+#include <bitset>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 
 #include <json/json.h>
 
 static_assert(JSONCPP_VERSION_HEXA >= ((1 << 24) | (8 << 16) | (0 << 8)), "JsonCPP library must be 1.8.0 or later version.");
 
 #include "details/nullable.h"
+#include "details/flat_map.h"
+#include "details/small_vector.h"
+#include "details/fixed_string.h"
+#include "details/interned_string.h"
 #include "details/tuple_utils.h"
+#include "details/json_writer.h"
+#include "details/json_reader.h"
+#include "details/json_extras.h"
+#include "details/json_producer.h"
+#include "details/json_consumer.h"
+#include "details/json_enum.h"
+#include "details/json_time.h"
+#include "details/json_variant.h"
+#include "details/json_shared.h"
+#include "details/thread_pool.h"
 
 #pragma pack(push, 8)
 
 namespace Json
 {
 
+// asynchronous emitting of JsonEx objects, defined in jsonex_emitter.h
+template<typename T> class JsonExEmitter;
+
+// errors of the reentrant const methods, returned instead of lastError() and errorInfo() of the object
+struct JsonExError
+{
+	// the same message as lastError() gives
+	std::string message;
+	// the same json path and message as errorInfo() gives, empty if the path is unknown
+	std::string info;
+};
+
 // Contain basic load/read/write json files functionality
 class JsonExBase
 {
+	template<typename> friend class JsonExEmitter;
+
 public:
 	JsonExBase() = default;
+	JsonExBase(const JsonExBase&) = default;
+	JsonExBase(JsonExBase&&) = default;
 	virtual ~JsonExBase() = default;
 
+	JsonExBase& operator=(const JsonExBase&) = default;
+	JsonExBase& operator=(JsonExBase&&) = default;
+
 public:
 	// returns string representation of the current json object.
 	std::string getJsonString(bool styled = true) const;
@@ -48,16 +88,42 @@ public:
 	// returns parse status.
 	bool load(const std::string &s);
 
-	// write json object to a stream.
+	// write json object to a stream, nothing is written on error.
 	bool write(std::ostream &os, bool styled = false) const;
 	// write json object to a string.
 	bool write(std::string &s, bool styled = false) const;
+	// write compact json object to a string, large arrays are written in parallel by the pool's threads.
+	bool write(std::string &s, utils::ThreadPool &pool) const;
+	// write compact json object into the sink by chunks of about the chunk size, so the whole text is never kept in memory.
+	// On error a part of the text may be already passed to the sink. If caching of JsonEx is enabled,
+	// the whole text is kept in the cache and passed to the sink from there.
+	bool write(const JsonExWriter::sink_type &sink, size_t chunkSize = JsonExWriter::sinkChunkSize) const;
+	// write compact json object into the fixed buffer, such as preallocated network frame. The size receives the length of the text.
+	// Returns false if the text does not fit the buffer, the text is not zero terminated.
+	bool write(char *buffer, size_t capacity, size_t &size) const;
+	// write compact json object as segments for writev/sendmsg. The text is written into the buffer,
+	// except long strings without chars to escape and cached text, which are referenced in the object's memory.
+	// The segments are valid while the buffer and the object are not changed.
+	bool write(std::string &buffer, std::vector<JsonExSegment> &segments) const;
+	// computes the exact length of compact json text by writing the text into a counting sink, the text is not kept.
+	// The next write gives the text of the same length unless the object is changed, so s.reserve(size) before write(s)
+	// gives the text in one allocation. Fails if the object has JsonExProducer fields, their items can be produced once only.
+	bool getJsonSize(size_t &size) const;
+	// reentrant writing of compact json object to a string, large arrays are written in parallel if the pool is set.
+	// The object is not changed and errors are returned in the error, cleared on success, so the same object can be written
+	// by many threads at once while nobody modifies it.
+	bool write(std::string &s, JsonExError &error, utils::ThreadPool *pool = nullptr) const;
+	// reentrant creation of json object, the object is not changed, errors are returned in the error, cleared on success
+	bool getJsonValue(Json::Value &v, JsonExError &error) const;
 
 	// returns the last error message of load/write json object
 	const std::string& lastError() const { return lastError_; }
 protected:
 	mutable std::string lastError_;
 
+	// writes compact json text directly into the string
+	bool writeCompact(std::string &s, utils::ThreadPool *pool) const;
+
 	// Validates this object against input json. Called before parse, and after create methods
 	// By default does nothing.
 	virtual bool validate(const Json::Value &) const { return true; };
@@ -69,6 +135,24 @@ protected:
 	// Called when this object should be converted into a json object.
 	// By default does nothing.
 	virtual bool create(Json::Value &) const { return true; };
+
+	// Called when this object should be written as compact json text.
+	// By default creates json object and writes it. JsonEx writes the text directly,
+	// unless its specialized type overrides create() or validate().
+	virtual bool serialize(JsonExWriter &writer) const;
+
+	// Called when this object should be read from json text.
+	// By default reads json object, validates and parses it. JsonEx reads the fields directly from the text,
+	// unless its specialized type overrides validate() or parse(), and reports the first invalid field of the text.
+	virtual bool deserialize(JsonExReader &reader);
+
+	// Called by reentrant methods, must not change this object. Errors are returned as json path and message.
+	// By default calls serialize.
+	virtual bool serializeShared(JsonExWriter &writer, std::string &) const { return serialize(writer); }
+
+	// Called by reentrant methods, must not change this object. Errors are returned as json path and message.
+	// By default calls create.
+	virtual bool createShared(Json::Value &root, std::string &) const { return create(root); }
 };
 
 inline std::string JsonExBase::getJsonString(bool styled/* = true*/) const
@@ -86,21 +170,20 @@ inline Json::Value JsonExBase::getJsonValue() const
 	return std::move(v);
 }
 
-inline bool JsonExBase::load(const std::string &s)
+inline bool JsonExBase::load(std::istream &is)
 {
-	std::istringstream iss(s);
-	return load(iss);
+	std::ostringstream oss;
+	oss << is.rdbuf();
+	return load(oss.str());
 }
 
-inline bool JsonExBase::load(std::istream &is)
+inline bool JsonExBase::load(const std::string &s)
 {
-	Json::Value value;
 	lastError_.clear();
 	try
 	{
-		is >> value;
-		if (!validate(value)) throw std::invalid_argument("Input json object is not valid");
-		if (!parse(value)) throw std::invalid_argument("Json object cannot be parsed");
+		JsonExReader reader(s.data(), s.data() + s.size());
+		if (!deserialize(reader)) throw std::invalid_argument("Input json object is not valid");
 	}
 	catch (std::exception &e)
 	{
@@ -112,14 +195,161 @@ inline bool JsonExBase::load(std::istream &is)
 
 inline bool JsonExBase::write(std::string &s, bool styled) const
 {
-	std::ostringstream oss;
-	if (!write(oss, styled)) return false;
-	s = oss.str();
+	if (styled)
+	{
+		std::ostringstream oss;
+		if (!write(oss, styled)) return false;
+		s = oss.str();
+		return true;
+	}
+
+	return writeCompact(s, nullptr);
+}
+
+inline bool JsonExBase::write(std::string &s, utils::ThreadPool &pool) const
+{
+	return writeCompact(s, &pool);
+}
+
+inline bool JsonExBase::write(const JsonExWriter::sink_type &sink, size_t chunkSize) const
+{
+	lastError_.clear();
+	std::string s;
+	JsonExWriter writer(s);
+	writer.setSink(sink, chunkSize);
+	try
+	{
+		if (!serialize(writer)) throw std::runtime_error("Cannot create json object");
+		writer.flush();
+	}
+	catch (std::exception& e)
+	{
+		lastError_ = e.what();
+		return false;
+	}
+	return true;
+}
+
+inline bool JsonExBase::write(char *buffer, size_t capacity, size_t &size) const
+{
+	size_t count = 0;
+	bool bValid = write([buffer, capacity, &count](const char* p, size_t len)
+	{
+		// stops writing as soon as the text exceeds the buffer
+		if (len > capacity - count) throw std::length_error("Json text exceeds the buffer size");
+		std::memcpy(buffer + count, p, len);
+		count += len;
+	}, JsonExWriter::copyChunkSize);
+	size = count;
+	return bValid;
+}
+
+inline bool JsonExBase::write(std::string &buffer, std::vector<JsonExSegment> &segments) const
+{
+	lastError_.clear();
+	buffer.clear();
+	segments.clear();
+	JsonExWriter writer(buffer);
+	writer.setReferencing(true);
+	try
+	{
+		if (!serialize(writer)) throw std::runtime_error("Cannot create json object");
+	}
+	catch (std::exception& e)
+	{
+		lastError_ = e.what();
+		return false;
+	}
+	writer.segments(segments);
+	return true;
+}
+
+inline bool JsonExBase::getJsonSize(size_t &size) const
+{
+	lastError_.clear();
+	size = 0;
+	std::string s;
+	JsonExWriter writer(s);
+	writer.setSink([&size](const char*, size_t len) { size += len; }, JsonExWriter::copyChunkSize);
+	writer.setSizing(true);
+	try
+	{
+		if (!serialize(writer)) throw std::runtime_error("Cannot create json object");
+		writer.flush();
+	}
+	catch (std::exception& e)
+	{
+		lastError_ = e.what();
+		return false;
+	}
+	return true;
+}
+
+inline bool JsonExBase::writeCompact(std::string &s, utils::ThreadPool *pool) const
+{
+	lastError_.clear();
+	s.clear();
+	JsonExWriter writer(s, pool);
+	try
+	{
+		if (!serialize(writer)) throw std::runtime_error("Cannot create json object");
+	}
+	catch (std::exception& e)
+	{
+		lastError_ = e.what();
+		return false;
+	}
 	return true;
 }
 
+inline bool JsonExBase::write(std::string &s, JsonExError &error, utils::ThreadPool *pool) const
+{
+	error = JsonExError();
+	s.clear();
+	JsonExWriter writer(s, pool);
+	writer.setShared(true);
+	std::string err;
+	try
+	{
+		if (serializeShared(writer, err)) return true;
+		error.message = "Cannot create json object";
+	}
+	catch (std::exception& e)
+	{
+		error.message = e.what();
+	}
+	error.info = err.empty() ? std::string() : std::string("$") + err;
+	return false;
+}
+
+inline bool JsonExBase::getJsonValue(Json::Value &v, JsonExError &error) const
+{
+	error = JsonExError();
+	std::string err;
+	try
+	{
+		if (createShared(v, err)) return true;
+		error.message = "Cannot create json object";
+	}
+	catch (std::exception& e)
+	{
+		error.message = e.what();
+	}
+	error.info = err.empty() ? std::string() : std::string("$") + err;
+	return false;
+}
+
 inline bool JsonExBase::write(std::ostream &os, bool styled) const
 {
+	if (!styled)
+	{
+		// the text is written to the stream only if the whole object is written
+		std::string s;
+		if (!write(s, false)) return false;
+		os.write(s.data(), static_cast<std::streamsize>(s.size()));
+		return !os.bad();
+	}
+
 	lastError_.clear();
 	Json::Value v;
 	try
@@ -134,12 +364,28 @@ inline bool JsonExBase::write(std::ostream &os, bool styled) const
 	}
 
 	Json::StreamWriterBuilder builder;
-	builder["indentation"] = styled ? std::string("\t") : std::string();
+	builder["indentation"] = std::string("\t");
 
 	std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
 	return writer->write(v, &os) == 0;
 }
 
+inline bool JsonExBase::serialize(JsonExWriter &writer) const
+{
+	Json::Value v;
+	if (!create(v)) return false;
+	if (!validate(v)) throw std::runtime_error("Created json object is not valid");
+	writer.writeValue(v);
+	return true;
+}
+
+inline bool JsonExBase::deserialize(JsonExReader &reader)
+{
+	Json::Value v;
+	reader.readValue(v);
+	return validate(v) && parse(v);
+}
+
 namespace
 {
 
@@ -192,10 +438,21 @@ inline std::ostream& operator<<(std::ostream& os, const JsonExBase& obj)
 //   data_attrs :-> an array of type JsonExAttributes::attr_type of count the tuple's size
 //   static const data_attrs& attributes(); :-> static method returning attributes array for each tuple's type
 //   enum data_enum: size_t; :-> enum with tuple's field indexes to access using JsonEx::data() method.
+// May be defined in the specialization:
+//   static const bool keep_extras = true; :-> unknown members of json object are kept as json text and written back.
 template<typename _ImplT> struct JsonExDataTraits
 {
 };
 
+// detects optional keep_extras flag of JsonExDataTraits specialization
+template<typename _Dt, typename = void> struct JsonExKeepExtras: std::false_type
+{
+};
+
+template<typename _Dt> struct JsonExKeepExtras<_Dt, typename std::enable_if<_Dt::keep_extras>::type>: std::true_type
+{
+};
+
 // Attribute definitions for JsonEx class
 struct JsonExAttributes
 {
@@ -209,213 +466,82 @@ struct JsonExAttributes
 	typedef std::tuple<std::string> attr_type;
 };
 
-/*
-Usage of the JsonEx class:
+// type erased methods of one field type, the values are passed by pointers. See JsonExCodec::FieldCodec()
+struct JsonExFieldCodec
+{
+	typedef JsonExAttributes::attr_type attr_type;
+
+	bool (*validate)(const Json::Value&, const attr_type&, std::ostream&);
+	bool (*parse)(const Json::Value&, const attr_type&, std::ostream&, void*);
+	bool (*create)(Json::Value&, const attr_type&, std::ostream&, const void*);
+	bool (*write)(JsonExWriter&, const attr_type&, std::string&, const void*);
+	bool (*writePatch)(JsonExWriter&, const attr_type&, std::string&, const void*);
+	bool (*read)(JsonExReader&, const attr_type&, std::string&, void*);
+	// resets changed fields of JsonEx based value, does nothing for other types
+	void (*clearDirty)(void*);
+	// copies the state, which the new value needs before reading, from the loaded value.
+	// Set for JsonExConsumer and JsonEx based types only.
+	void (*prepare)(void*, const void*);
+	// the value is json object merged by merge patch, its patch is computed from the text of the previous value
+	bool merged;
+};
 
-//class CSubObjType; // forward declaration required
-//template<> struct Json::JsonExDataTraits<CSubObjType>
-//{
-//	enum data_enum: size_t
-//	{
-//		AttrA = 0, AttrB = 1, AttrV = 2
-//	};
-//
-//	using data_type = std::tuple<int, int, utils::Nullable<std::array<int, 3>> >;
-//	using attr_type = JsonExAttributes::attr_type;
-//	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
-//
-//	static const data_attrs& attributes()
-//	{
-//		static const data_attrs attrs
-//		{
-//			{
-//				attr_type(std::string("a")), attr_type(std::string("b")), attr_type(std::string("v"))
-//			}
-//		};
-//		return attrs;
-//	}
-//
-//};
-//class CSubObjType: public Json::JsonEx<CSubObjType>
-//{
-//public:
-//	CSubObjType() = default;
-//	explicit CSubObjType(const data_type& other): base_type(other) {}
-//	explicit CSubObjType(data_type&& other): base_type(std::forward<data_type>(other)) {}
-//};
-//
-//class CMainType; // forward declaration	required
-//template<> struct Json::JsonExDataTraits<CMainType>
-//{
-//	enum data_enum: size_t
-//	{
-//		AttrBoolValue = 0, AttrUIntValue = 1, AttrVec = 2,
-//		AttrObj = 3, AttrVecObj = 4, AttrVecObjFixedSize = 5
-//	};
-//
-//	using data_type = std::tuple<bool, utils::Nullable<unsigned int>, std::vector<int>, utils::Nullable<CSubObjType>, utils::Nullable< std::vector<CSubObjType>>, utils::Nullable< std::array<CSubObjType, 2>> >;
-//	using attr_type = JsonExAttributes::attr_type;
-//
-//	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
-//	static const data_attrs& attributes()
-//	{
-//		static const data_attrs attrs
-//		{
-//			{
-//				attr_type(std::string("boolVal")), attr_type(std::string("uintVal")), attr_type(std::string("vec")),
-//				attr_type(std::string("obj")), attr_type(std::string("vecObj")), attr_type(std::string("vecObjFixedSize"))
-//			}
-//		};
-//		return attrs;
-//	}
-//};
-//
-//class CMainType: public Json::JsonEx<CMainType>
-//{
-//public:
-//	CMainType() = default;
-//	explicit CMainType(const data_type& other): base_type(other) {}
-//	explicit CMainType(data_type&& other): base_type(std::forward<data_type>(other)) {}
-//};
-//
-Code to use:
+// comparators ordering the keys of associative containers the same as json object does
+template<typename C> struct JsonKeyOrdered: std::false_type
+{
+};
 
-CMainType mainType;
-bool b = mainType.load(jsonString);
-std::string s = mainType.getJsonString();
-*/
+template<> struct JsonKeyOrdered<std::less<std::string>>: std::true_type
+{
+};
 
-template<typename _ImplT, typename _Dt = JsonExDataTraits<_ImplT> >
-class JsonEx: public JsonExBase
+template<> struct JsonKeyOrdered<utils::TransparentLess>: std::true_type
 {
-public:
-	typedef _ImplT main_type;
-	typedef JsonEx base_type;
-	typedef _Dt data_traits;
+};
 
-	// tuple data type
-	typedef typename data_traits::data_type data_type;
-	// array of atributes for the data types
-	typedef typename data_traits::data_attrs data_attrs;
-	// enum to access data typle
-	typedef typename data_traits::data_enum data_enum;
-	// predefined attributes class
-	typedef JsonExAttributes attr_traits;
-	// attributes tuple type
-	typedef typename attr_traits::attr_type attr_type;
-	// enum to access attributes tuple
-	typedef typename attr_traits::attr_enum attr_enum;
+// field types written as json objects which are not JsonEx based: merge patch merges them into the target's objects,
+// so their patch removes the missing members of the previous value by null
+template<typename T> struct JsonExMergedObject: std::false_type
+{
+};
 
-	static_assert(std::tuple_size<data_type>::value == std::tuple_size<data_attrs>::value, "invalid data_attrs array size");
-	static_assert(std::is_enum<data_enum>::value, "invalid data_enum type");
-	static_assert(std::is_enum<attr_enum>::value, "invalid attr_enum type");
+template<typename T, typename C, typename A> struct JsonExMergedObject<std::map<std::string, T, C, A>>: std::true_type
+{
+};
 
-public:
-	JsonEx() = default;
-	explicit JsonEx(const data_type& other): data_(other) {}
-	explicit JsonEx(data_type&& other): data_(std::forward<data_type>(other)) {}
-	~JsonEx() override = default;
+template<typename T, typename H, typename E, typename A> struct JsonExMergedObject<std::unordered_map<std::string, T, H, E, A>>: std::true_type
+{
+};
 
-	// static object types validation for json object
-	static bool JsonValidate(const Json::Value &root, std::ostream& err)
-	{
-		std::ostringstream ss;
-		size_t iInvalidField = utils::find_if(*static_cast<data_type*>(nullptr), FnTypeValidate<data_type>(root, data_traits::attributes(), ss));
-		bool bValid = iInvalidField >= std::tuple_size<data_type>::value;
-		if (!bValid)
-		{
-			err << "." << std::get<attr_enum::AttrIndexName>(data_traits::attributes()[iInvalidField]) << ss.str();
-		}
-		return bValid;
-	}
+template<typename T, typename C> struct JsonExMergedObject<utils::FlatMap<std::string, T, C>>: std::true_type
+{
+};
 
-	// parse input json object into output JsonEx specialized object
-	static bool JsonParse(const Json::Value &root, JsonEx& obj, std::ostream& err)
-	{
-		std::ostringstream ss;
-		bool bValid = JsonValidate(root, ss);
-		if (!bValid)
-		{
-			err << ss.str();
-			return false;
-		}
-		ss = std::ostringstream();
-		size_t iInvalidField = utils::find_if(obj.data_, FnValueParse<data_type>(root, data_traits::attributes(), ss));
-		bValid = iInvalidField >= std::tuple_size<data_type>::value;
-		if (!bValid)
-		{
-			err << "." << std::get<attr_enum::AttrIndexName>(data_traits::attributes()[iInvalidField]) << ss.str();
-			return false;
-		}
-		return bValid;
-	}
-
-	// creates json object from input JsonEx specialized object
-	static bool JsonCreate(Json::Value &root, const JsonEx& obj, std::ostream& err)
-	{
-		std::ostringstream ss;
-		Json::Value jsonObj(Json::objectValue);
-		size_t iInvalidField = utils::find_if(obj.data_, FnValueCreate<data_type>(jsonObj, data_traits::attributes(), ss));
-		bool bValid = iInvalidField >= std::tuple_size<data_type>::value;
-		if (bValid)
-		{
-			root = jsonObj;
-		}
-		else
-		{
-			err << "." << std::get<attr_enum::AttrIndexName>(data_traits::attributes()[iInvalidField]) << ss.str();
-		}
-		return bValid;
-	}
-
-	// access to data object
-	data_type& data() { return data_; }
-	const data_type& data() const { return data_; }
+template<typename T> struct JsonExMergedObject<utils::Nullable<T>>: JsonExMergedObject<T>
+{
+};
 
-	// contains error json path and a message, can be used to identify invalid entries
-	const std::string& errorInfo() const
-	{
-		return errorInfo_;
-	}
+template<typename T> struct JsonExMergedObject<JsonExShared<T>>: JsonExMergedObject<T>
+{
+};
 
-protected:
-	// main data storage
-	data_type data_;
-	mutable std::string errorInfo_;
+// the alternatives have different members
+template<typename K, typename... Ts> struct JsonExMergedObject<JsonExVariant<K, Ts...>>: std::true_type
+{
+};
 
-protected:
-	bool validate(const Json::Value &root) const override
-	{
-		std::ostringstream err;
-		bool bValid = JsonValidate(root, err);
-		if (!bValid)
-		{
-			errorInfo_ = std::string("$") + err.str();
-		}
-		return bValid;
-	}
-	bool parse(const Json::Value &root) override
-	{
-		std::ostringstream err;
-		bool bValid = JsonParse(root, *this, err);
-		if (!bValid)
-		{
-			errorInfo_ = std::string("$") + err.str();
-		}
-		return bValid;
-	}
-	bool create(Json::Value &root) const override
-	{
-		std::ostringstream err;
-		bool bValid = JsonCreate(root, *this, err);
-		if (!bValid)
-		{
-			errorInfo_ = std::string("$") + err.str();
-		}
-		return bValid;
-	}
+/*
+Json methods of the field types: validation, parsing and creation of json objects, json text writing and reading.
+The methods depend on the field type only, so they are instantiated once per field type
+and shared by all JsonEx types, which access them through the JsonExFieldCodec tables.
+*/
+class JsonExCodec
+{
+public:
+	// attributes tuple type
+	typedef JsonExAttributes::attr_type attr_type;
 
-protected:
+public:
 	// store type and value in template	arguments
 	template<typename _Ty, _Ty _Val> struct value_constant {};
 
@@ -429,8 +555,8 @@ protected:
 	template<typename _Rt, MethodTypePointer<bool, Json::Value> P>
 	using JsonValidateMethodTypePointer = std::pair<_Rt, value_constant<MethodTypePointer<bool, Json::Value>, P>>;
 
-protected:
-	template<typename T, typename std::enable_if< !(std::is_base_of<JsonExBase, T>::value || std::is_arithmetic<T>::value || std::is_same<T, std::string>::value) >::type * = nullptr>
+public:
+	template<typename T, typename std::enable_if< !(std::is_base_of<JsonExBase, T>::value || std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_same<T, std::string>::value) >::type * = nullptr>
 	// main json type validation template method
 	static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const T&)
 	{
@@ -451,6 +577,13 @@ protected:
 		return JsonTypeValidate(json, attr, err, *static_cast<T*>(nullptr));
 	}
 
+	// JsonExShared<T> overload json type validation, the same as utils::Nullable<T> has
+	template<typename T> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExShared<T>&)
+	{
+		if (json.isNull()) return true;
+		return JsonTypeValidate(json, attr, err, *static_cast<T*>(nullptr));
+	}
+
 	template<typename _Tt, typename _Need_t>
 	// search the needed type in the tuple and update the value with called function
 	struct FnValidateBasicTypes
@@ -542,27 +675,176 @@ protected:
 		return true;
 	}
 
-	template<typename TupleType>
-	// functor to call tuple validation
-	struct FnTypeValidate
+	// JsonExVariant overload json type validation by the alternative of the discriminator
+	template<typename K, typename... Ts> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExVariant<K, Ts...>&)
 	{
-		FnTypeValidate(const Json::Value &root, const data_attrs& names, std::ostream& err): root_(root), names_(names), err_(err) {}
+		if (json.isNull()) return true;
+		size_t index = 0;
+		if (!JsonVariantFind<K, Ts...>(json, index, err)) return false;
+		typedef bool (*validate_type)(const Json::Value&, std::ostream&);
+		static const validate_type validators[] = { &Ts::JsonValidate... };
+		return validators[index](json, err);
+	}
 
-		template<typename T, size_t _Index> bool operator() (std::integral_constant<size_t, _Index>, const T& value) const
+	// finds the alternative of JsonExVariant by the discriminator member of json object
+	template<typename K, typename... Ts> static bool JsonVariantFind(const Json::Value& json, size_t& index, std::ostream& err)
+	{
+		typedef JsonExVariant<K, Ts...> variant_type;
+		if (!json.isObject())
 		{
-			const attr_type& attr = std::get<_Index>(names_);
-			bool bValid = JsonTypeValidate(root_[std::get<attr_enum::AttrIndexName>(attr)], attr, err_, value);
-			return !bValid;
-		};
+			err << " -> invalid type, must be object.";
+			return false;
+		}
+		const Json::Value* member = json.find(variant_type::key(), variant_type::key() + std::strlen(variant_type::key()));
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!member)
+		{
+			err << "." << variant_type::key() << " -> missing discriminator.";
+			return false;
+		}
+		if (!member->isString() || !member->getString(&b, &e))
+		{
+			err << "." << variant_type::key() << " -> invalid value type.";
+			return false;
+		}
+		index = variant_type::find(b, e - b);
+		if (index == variant_type::npos)
+		{
+			err << "." << variant_type::key() << " -> unknown discriminator '" << std::string(b, e) << "'.";
+			return false;
+		}
+		return true;
+	}
 
-		const Json::Value& root_;
-		const data_attrs& names_;
-		std::ostream& err_;
-	};
+	// system_clock::time_point overload json type validation: RFC 3339 string or number of seconds since the epoch
+	template<typename D> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const std::chrono::time_point<std::chrono::system_clock, D>&)
+	{
+		std::chrono::time_point<std::chrono::system_clock, D> value;
+		return JsonValueParse(json, attr, err, value);
+	}
 
-protected:
+	// std::chrono::duration overload json type validation: number of the duration's units
+	template<typename Rep, typename Period> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const std::chrono::duration<Rep, Period>&)
+	{
+		std::chrono::duration<Rep, Period> value;
+		return JsonValueParse(json, attr, err, value);
+	}
+
+	// enum overload json type validation, the name must be in JsonExEnumTraits<T>::names()
+	template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+	static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const T&)
+	{
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!json.isString() || !json.getString(&b, &e))
+		{
+			err << " -> invalid value type.";
+			return false;
+		}
+		T v;
+		if (!JsonExEnumTraits<T>::names().find(b, e - b, v))
+		{
+			err << " -> unknown enum name '" << std::string(b, e) << "'.";
+			return false;
+		}
+		return true;
+	}
+
+	// utils::SmallVector<T, N> and utils::BoundedVector<T, N> overload json type validation
+	template<typename T, size_t N, bool bGrow> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const utils::InlineVector<T, N, bGrow>&)
+	{
+		if (!bGrow && json.isArray() && json.size() > N)
+		{
+			err << " -> invalid array size " << json.size() << " > " << N << ".";
+			return false;
+		}
+		return JsonTypeValidate(json, attr, err, *static_cast<const std::vector<T>*>(nullptr));
+	}
+
+	// utils::FixedString<N> overload json type validation
+	template<size_t N> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const utils::FixedString<N>&)
+	{
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!json.isString() || !json.getString(&b, &e))
+		{
+			err << " -> invalid value type.";
+			return false;
+		}
+		if (static_cast<size_t>(e - b) > N)
+		{
+			err << " -> invalid string length " << (e - b) << " > " << N << ".";
+			return false;
+		}
+		return true;
+	}
+
+	// utils::InternedString overload json type validation
+	static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const utils::InternedString&)
+	{
+		if (!json.isString())
+		{
+			err << " -> invalid value type.";
+			return false;
+		}
+		return true;
+	}
+
+	// JsonExProducer<T> overload json type validation, the same as vector<T> has
+	template<typename T> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExProducer<T>&)
+	{
+		return JsonTypeValidate(json, attr, err, *static_cast<const std::vector<T>*>(nullptr));
+	}
+
+	// JsonExConsumer<T> overload json type validation, the same as vector<T> has
+	template<typename T> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExConsumer<T>&)
+	{
+		return JsonTypeValidate(json, attr, err, *static_cast<const std::vector<T>*>(nullptr));
+	}
+
+	// std::map<std::string, T> overload json type validation
+	template<typename T, typename C, typename A> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const std::map<std::string, T, C, A>&)
+	{
+		return JsonObjectValidate<T>(json, attr, err);
+	}
+
+	// std::unordered_map<std::string, T> overload json type validation
+	template<typename T, typename H, typename E, typename A> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const std::unordered_map<std::string, T, H, E, A>&)
+	{
+		return JsonObjectValidate<T>(json, attr, err);
+	}
+
+	// utils::FlatMap<std::string, T> overload json type validation
+	template<typename T, typename C> static bool JsonTypeValidate(const Json::Value& json, const attr_type& attr, std::ostream& err, const utils::FlatMap<std::string, T, C>&)
+	{
+		return JsonObjectValidate<T>(json, attr, err);
+	}
+
+	// json object with any keys and values of the same type validation, used by associative containers
+	template<typename T> static bool JsonObjectValidate(const Json::Value& json, const attr_type& attr, std::ostream& err)
+	{
+		if (!json.isObject())
+		{
+			err << " -> invalid type, must be object.";
+			return false;
+		}
+		std::ostringstream ss;
+		for (Json::Value::const_iterator it = json.begin(); it != json.end(); ++it)
+		{
+			bool bValid = JsonTypeValidate(*it, attr, ss, *static_cast<T*>(nullptr));
+			if (!bValid)
+			{
+				err << "." << it.name() << ss.str();
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
 	template<typename T, typename std::enable_if< !(std::is_base_of<JsonExBase, T>::value ||
-		std::is_arithmetic<T>::value || std::is_same<T, std::string>::value)>::type * = nullptr
+		std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_same<T, std::string>::value)>::type * = nullptr
 	>
 	// main json type validation template method
 	static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, T&)
@@ -592,6 +874,21 @@ protected:
 		return bValid;
 	}
 
+	// JsonExShared<T> overload json parsing. Json object keeps no text to compare, so the value is always parsed anew
+	template<typename T> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, JsonExShared<T>& value)
+	{
+		if (json.isNull())
+		{
+			value.reset();
+			return true;
+		}
+
+		T v;
+		bool bValid = JsonValueParse(json, attr, err, v);
+		if (bValid) value = JsonExShared<T>(std::move(v));
+		return bValid;
+	}
+
 	template<typename _Tt, typename _Nt>
 	// search the needed type in the tuple and update the value with called function
 	struct FnParseBasicTypes
@@ -684,121 +981,2347 @@ protected:
 		return true;
 	}
 
-	template<typename _Tt>
-	// functor to call tuple parsing
-	struct FnValueParse
+	// JsonExVariant overload json value parse, the object is parsed by the alternative of the discriminator
+	template<typename K, typename... Ts> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, JsonExVariant<K, Ts...>& value)
 	{
-		FnValueParse(const Json::Value &root, const data_attrs& names, std::ostream& err): root_(root), names_(names), err_(err) {}
-
-		template<typename T, size_t _Index> bool operator() (std::integral_constant<size_t, _Index>, T& value) const
+		if (json.isNull())
 		{
-			const attr_type& attr = std::get<_Index>(names_);
-			bool bValid = JsonValueParse(root_[std::get<attr_enum::AttrIndexName>(attr)], attr, err_, value);
-			return !bValid;
-		};
-
-		const Json::Value& root_;
-		const data_attrs& names_;
-		std::ostream& err_;
-	};
+			value.reset();
+			return true;
+		}
+		size_t index = 0;
+		if (!JsonVariantFind<K, Ts...>(json, index, err)) return false;
+		typedef bool (*parse_type)(const Json::Value&, const attr_type&, std::ostream&, JsonExVariant<K, Ts...>&);
+		static const parse_type parsers[] = { &JsonVariantParse<Ts, K, Ts...>... };
+		return parsers[index](json, attr, err, value);
+	}
 
-protected:
-	template<typename T, typename std::enable_if<!(std::is_base_of<JsonExBase, T>::value || std::is_arithmetic<T>::value || std::is_same<T, std::string>::value)>::type * = nullptr>
-	// main json creation template method
-	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T&)
+	template<typename T, typename K, typename... Ts> static bool JsonVariantParse(const Json::Value& json, const attr_type& attr, std::ostream& err, JsonExVariant<K, Ts...>& value)
 	{
-		static_assert(false, "Json creation for this type not implemented");
+		T obj;
+		if (!JsonValueParse(json, attr, err, obj)) return false;
+		value.template emplace<T>(std::move(obj));
+		return true;
 	}
 
-	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
-	// json creation for JsonExBase based types/subtypes template method
-	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T& obj)
+	// system_clock::time_point overload json value parse
+	template<typename D> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, std::chrono::time_point<std::chrono::system_clock, D>& value)
 	{
-		return T::JsonCreate(json, obj, err);
+		long long seconds = 0;
+		long nanos = 0;
+		bool bValid = false;
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (json.isString() && json.getString(&b, &e))
+		{
+			bValid = utils::json_time_parse(b, e, seconds, nanos);
+		}
+		else if (json.isDouble())
+		{
+			bValid = JsonEpochTime(json, seconds, nanos);
+		}
+		else
+		{
+			err << " -> invalid value type.";
+			return false;
+		}
+		if (!bValid || !utils::json_time_make(seconds, nanos, value))
+		{
+			err << " -> invalid time value.";
+			return false;
+		}
+		return true;
 	}
 
-	// utils::Nullable<T> overload json value create
-	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::Nullable<T>& obj)
+	// std::chrono::duration overload json value parse
+	template<typename Rep, typename Period> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, std::chrono::duration<Rep, Period>& value)
 	{
-		if (!obj)
+		Rep count = Rep();
+		if (!json.isDouble() || !JsonNumberAs(json, count, std::is_floating_point<Rep>()))
 		{
-			json = Json::Value::nullSingleton();
-			return true;
+			err << " -> invalid value.";
+			return false;
 		}
-		return JsonValueCreate(json, attr, err, obj.value());
+		value = std::chrono::duration<Rep, Period>(count);
+		return true;
 	}
 
-	template<typename T, typename std::enable_if< std::is_arithmetic<T>::value || std::is_same<T, std::string>::value>::type * = nullptr>
-	// json creation for arithmetic and string types template method
-	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T& value)
+	// seconds since the epoch of Json::Value or JsonExNumber number
+	template<typename N> static bool JsonEpochTime(const N& number, long long& seconds, long& nanos)
 	{
-		json = Json::Value(value);
+		if (!number.isInt64()) return utils::json_time_from_epoch(number.asDouble(), seconds, nanos);
+		seconds = number.asInt64();
+		nanos = 0;
 		return true;
 	}
 
-	// vector<T> overload json value create
-	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::vector<T>& value)
+	// converts Json::Value or JsonExNumber number to the integral type, returns false if the number does not fit
+	template<typename N, typename T> static bool JsonNumberAs(const N& number, T& value, std::false_type)
 	{
-		Json::Value jsonV(Json::arrayValue);
-		for (size_t i = 0; i < value.size(); i++)
+		if (!number.isInt64()) return false;
+		Json::Int64 v = number.asInt64();
+		if (v < 0 ? (!std::is_signed<T>::value || v < static_cast<Json::Int64>(std::numeric_limits<T>::min())) :
+			static_cast<Json::UInt64>(v) > static_cast<Json::UInt64>(std::numeric_limits<T>::max())) return false;
+		value = static_cast<T>(v);
+		return true;
+	}
+	template<typename N, typename T> static bool JsonNumberAs(const N& number, T& value, std::true_type)
+	{
+		value = static_cast<T>(number.asDouble());
+		return true;
+	}
+
+	// enum overload json value parse
+	template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+	static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, T& value)
+	{
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!json.getString(&b, &e) || !JsonExEnumTraits<T>::names().find(b, e - b, value))
+		{
+			err << " -> invalid value.";
+			return false;
+		}
+		return true;
+	}
+
+	// utils::SmallVector<T, N> and utils::BoundedVector<T, N> overload json value parse
+	template<typename T, size_t N, bool bGrow> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, utils::InlineVector<T, N, bGrow>& value)
+	{
+		if (!json.isArray())
+		{
+			err << " -> invalid type, must be array.";
+			return false;
+		}
+		if (!bGrow && json.size() > N)
+		{
+			err << " -> invalid array size " << json.size() << " > " << N << ".";
+			return false;
+		}
+		value.clear();
+		value.reserve(json.size());
+		for (Json::ArrayIndex i = 0; i < json.size(); i++)
 		{
 			std::ostringstream ss;
-			Json::Value v;
-			if (JsonValueCreate(v, attr, ss, value[i]))
-			{
-				jsonV.append(std::move(v));
-			}
-			else
+			if (!JsonValueParse(json[i], attr, ss, value.emplace_back()))
 			{
 				err << "[" << i << "]" << ss.str();
 				return false;
 			}
 		}
-		json.swap(jsonV);
 		return true;
 	}
 
-	// fixed size array overload json value create
-	template<typename T, size_t Size> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::array<T, Size>& value)
+	// utils::FixedString<N> overload json value parse
+	template<size_t N> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, utils::FixedString<N>& value)
 	{
-		Json::Value jsonV(Json::arrayValue);
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!json.getString(&b, &e) || !value.try_assign(b, e - b))
+		{
+			err << " -> invalid value.";
+			return false;
+		}
+		return true;
+	}
+
+	// utils::InternedString overload json value parse, a known string is found without allocation
+	static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, utils::InternedString& value)
+	{
+		const char* b = nullptr;
+		const char* e = nullptr;
+		if (!json.getString(&b, &e))
+		{
+			err << " -> invalid value.";
+			return false;
+		}
+		try
+		{
+			value = utils::InternedString(b, e - b);
+		}
+		catch (std::length_error&)
+		{
+			err << " -> too many interned strings.";
+			return false;
+		}
+		return true;
+	}
+
+	// JsonExProducer<T> overload json value parse, the items are kept in the vector
+	template<typename T> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, JsonExProducer<T>& value)
+	{
+		std::vector<T> items;
+		if (!JsonValueParse(json, attr, err, items)) return false;
+		value = JsonExProducer<T>(std::move(items));
+		return true;
+	}
+
+	// JsonExConsumer<T> overload json value parse, the items are passed to the consumer
+	template<typename T> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, JsonExConsumer<T>& value)
+	{
+		if (!json.isArray())
+		{
+			err << " -> invalid type, must be array.";
+			return false;
+		}
+		value.reset();
+		for (Json::ArrayIndex i = 0; i < json.size(); i++)
+		{
+			std::ostringstream ss;
+			T item;
+			if (!JsonValueParse(json[i], attr, ss, item))
+			{
+				err << "[" << i << "]" << ss.str();
+				return false;
+			}
+			if (!value.consume(std::move(item)))
+			{
+				err << "[" << i << "] -> stopped by the consumer.";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// std::map<std::string, T> overload json value parse
+	template<typename T, typename C, typename A> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, std::map<std::string, T, C, A>& value)
+	{
+		return JsonObjectParse(json, attr, err, value);
+	}
+
+	// std::unordered_map<std::string, T> overload json value parse
+	template<typename T, typename H, typename E, typename A> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, std::unordered_map<std::string, T, H, E, A>& value)
+	{
+		return JsonObjectParse(json, attr, err, value);
+	}
+
+	// utils::FlatMap<std::string, T> overload json value parse
+	template<typename T, typename C> static bool JsonValueParse(const Json::Value& json, const attr_type& attr, std::ostream& err, utils::FlatMap<std::string, T, C>& value)
+	{
+		return JsonObjectParse(json, attr, err, value);
+	}
+
+	// json object with any keys parse into associative container.
+	// The container is reserved for all the members, keys are moved into the container.
+	template<typename M> static bool JsonObjectParse(const Json::Value& json, const attr_type& attr, std::ostream& err, M& value)
+	{
+		if (!json.isObject())
+		{
+			err << " -> invalid type, must be object.";
+			return false;
+		}
+		value.clear();
+		JsonMapReserve(value, json.size());
+
+		std::ostringstream ss;
+		for (Json::Value::const_iterator it = json.begin(); it != json.end(); ++it)
+		{
+			const char* end = nullptr;
+			const char* name = it.memberName(&end);
+			typename M::mapped_type v;
+			bool bValid = JsonValueParse(*it, attr, ss, v);
+			if (!bValid)
+			{
+				err << "." << std::string(name, end) << ss.str();
+				return false;
+			}
+			JsonMapEmplace(value, std::string(name, end), std::move(v));
+		}
+		JsonMapFinish(value);
+		return true;
+	}
+
+	// associative containers building helpers, json object members usually come in the sorted order
+	template<typename T, typename C, typename A> static void JsonMapReserve(std::map<std::string, T, C, A>&, size_t) {}
+	template<typename T, typename H, typename E, typename A> static void JsonMapReserve(std::unordered_map<std::string, T, H, E, A>& value, size_t size) { value.reserve(size); }
+	template<typename T, typename C> static void JsonMapReserve(utils::FlatMap<std::string, T, C>& value, size_t size) { value.reserve(size); }
+
+	template<typename T, typename C, typename A> static void JsonMapEmplace(std::map<std::string, T, C, A>& value, std::string&& key, T&& v)
+	{
+		// the last of duplicate keys wins, the same as json object has
+		if (value.empty() || value.rbegin()->first < key) value.emplace_hint(value.end(), std::move(key), std::move(v));
+		else value[std::move(key)] = std::move(v);
+	}
+	template<typename T, typename H, typename E, typename A> static void JsonMapEmplace(std::unordered_map<std::string, T, H, E, A>& value, std::string&& key, T&& v)
+	{
+		value[std::move(key)] = std::move(v);
+	}
+	template<typename T, typename C> static void JsonMapEmplace(utils::FlatMap<std::string, T, C>& value, std::string&& key, T&& v)
+	{
+		value.emplace_back_unsorted(std::move(key), std::move(v));
+	}
+
+	template<typename M> static void JsonMapFinish(M&) {}
+	template<typename T, typename C> static void JsonMapFinish(utils::FlatMap<std::string, T, C>& value) { value.sort_unique(); }
+
+public:
+	// Json text reading methods read values directly from the text, without json object creation.
+	// Errors are reported into the string, nested methods prepend the path of the failed value.
+
+	template<typename T, typename std::enable_if< !(std::is_base_of<JsonExBase, T>::value || JsonExReadable<T>::value || std::is_enum<T>::value)>::type * = nullptr>
+	// types without direct reading are read into json object, then validated and parsed
+	static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, T& value)
+	{
+		Json::Value json;
+		reader.readValue(json);
+		std::ostringstream ss;
+		bool bValid = JsonTypeValidate(json, attr, ss, value) && JsonValueParse(json, attr, ss, value);
+		if (!bValid) err = ss.str();
+		return bValid;
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	// json text reading for JsonExBase based types/subtypes template method
+	static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, T& obj)
+	{
+		return T::JsonRead(reader, obj, err);
+	}
+
+	// basic types are read directly with the same type checks as JsonTypeValidate does.
+	// Other arithmetic types are read by the json object overload, which reports them as invalid.
+	template<typename T, typename std::enable_if< JsonExReadable<T>::value>::type * = nullptr>
+	static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, T& value)
+	{
+		if (reader.read(value)) return true;
+		err = " -> invalid value type.";
+		return false;
+	}
+
+	// utils::Nullable<T> overload json text reading
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, utils::Nullable<T>& obj)
+	{
+		if (reader.peek() == JsonExReader::tokenNull)
+		{
+			reader.readNull();
+			obj = nullptr;
+			return true;
+		}
+
+		T v;
+		bool bValid = JsonValueRead(reader, attr, err, v);
+		if (bValid) obj = std::move(v);
+		return bValid;
+	}
+
+	// JsonExShared<T> overload json text reading. The field prepared from the previous object keeps its value
+	// if the text of the value is the same, otherwise the value is read with its own shared fields prepared from the previous value
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, JsonExShared<T>& value)
+	{
+		if (reader.peek() == JsonExReader::tokenNull)
+		{
+			reader.readNull();
+			value.reset();
+			return true;
+		}
+
+		JsonExReader::mark_type start = reader.mark();
+		reader.skipValue();
+		size_t len = static_cast<size_t>(reader.position() - start.pos);
+		if (value.matches(start.pos, len)) return true;
+		reader.reset(start);
+
+		T v;
+		field_prepare_fn prepare = FieldPrepare(static_cast<T*>(nullptr));
+		if (prepare && value) prepare(&v, &value.get());
+		if (!JsonValueRead(reader, attr, err, v)) return false;
+		value.assign(std::move(v), start.pos, len);
+		return true;
+	}
+
+	// vector of JsonExShared<T> overload json text reading, the items are compared with the previous items of the same index
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::vector<JsonExShared<T>>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be array.";
+			return false;
+		}
+		std::vector<JsonExShared<T>> items;
+		if (reader.beginArray())
+		{
+			do
+			{
+				items.push_back(items.size() < value.size() ? value[items.size()] : JsonExShared<T>());
+				if (!JsonValueRead(reader, attr, err, items.back()))
+				{
+					err.insert(0, "[" + std::to_string(items.size() - 1) + "]");
+					return false;
+				}
+			} while (reader.nextElement());
+		}
+		value = std::move(items);
+		return true;
+	}
+
+	// vector<T> overload json text reading
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::vector<T>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be array.";
+			return false;
+		}
+		value.clear();
+		if (!reader.beginArray()) return true;
+		do
+		{
+			value.push_back(T());
+			if (!JsonValueRead(reader, attr, err, value.back()))
+			{
+				err.insert(0, "[" + std::to_string(value.size() - 1) + "]");
+				return false;
+			}
+		} while (reader.nextElement());
+		return true;
+	}
+
+	// fixed size array overload json text reading
+	template<typename T, size_t Size> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::array<T, Size>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be fixed size (" + std::to_string(Size) + ") array.";
+			return false;
+		}
+		size_t count = 0;
+		if (reader.beginArray())
+		{
+			do
+			{
+				if (count >= Size)
+				{
+					// the rest is counted for the error message only
+					reader.skipValue();
+				}
+				else if (!JsonValueRead(reader, attr, err, value[count]))
+				{
+					err.insert(0, "[" + std::to_string(count) + "]");
+					return false;
+				}
+				count++;
+			} while (reader.nextElement());
+		}
+		if (count != Size)
+		{
+			err = " -> invalid fixed size array " + std::to_string(count) + " != " + std::to_string(Size) + ".";
+			return false;
+		}
+		return true;
+	}
+
+	// JsonExVariant overload json text reading. The discriminator is found by looking ahead at the token level,
+	// then the object is read once by the alternative of the discriminator
+	template<typename K, typename... Ts> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, JsonExVariant<K, Ts...>& value)
+	{
+		typedef JsonExVariant<K, Ts...> variant_type;
+		JsonExReader::token_type token = reader.peek();
+		if (token == JsonExReader::tokenNull)
+		{
+			reader.readNull();
+			value.reset();
+			return true;
+		}
+		if (token != JsonExReader::tokenObject)
+		{
+			err = " -> invalid type, must be object.";
+			return false;
+		}
+
+		JsonExReader::mark_type start = reader.mark();
+		const char* key = variant_type::key();
+		size_t keySize = std::strlen(key);
+		std::string scratch;
+		size_t index = variant_type::npos;
+		bool bFound = false;
+		if (reader.beginObject())
+		{
+			do
+			{
+				const char* b = nullptr;
+				const char* e = nullptr;
+				reader.readKey(b, e, scratch);
+				if (keySize == static_cast<size_t>(e - b) && std::memcmp(key, b, keySize) == 0)
+				{
+					bFound = true;
+					if (reader.peek() != JsonExReader::tokenString)
+					{
+						err = "." + std::string(key) + " -> invalid value type.";
+					}
+					else
+					{
+						reader.readStringView(b, e, scratch);
+						index = variant_type::find(b, e - b);
+						if (index == variant_type::npos) err = "." + std::string(key) + " -> unknown discriminator '" + std::string(b, e) + "'.";
+					}
+					break;
+				}
+				reader.skipValue();
+			} while (reader.nextMember());
+		}
+		if (!bFound) err = "." + std::string(key) + " -> missing discriminator.";
+		if (index == variant_type::npos) return false;
+		reader.reset(start);
+
+		typedef bool (*read_type)(JsonExReader&, const attr_type&, std::string&, variant_type&);
+		static const read_type readers[] = { &JsonVariantRead<Ts, K, Ts...>... };
+		return readers[index](reader, attr, err, value);
+	}
+
+	template<typename T, typename K, typename... Ts> static bool JsonVariantRead(JsonExReader& reader, const attr_type& attr, std::string& err, JsonExVariant<K, Ts...>& value)
+	{
+		// the held object of the same type is read in place, so its consumers are kept
+		if (!value.template is<T>()) value.template emplace<T>();
+		return JsonValueRead(reader, attr, err, value.template get<T>());
+	}
+
+	// system_clock::time_point overload json text reading
+	template<typename D> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::chrono::time_point<std::chrono::system_clock, D>& value)
+	{
+		long long seconds = 0;
+		long nanos = 0;
+		bool bValid = false;
+		JsonExReader::token_type token = reader.peek();
+		if (token == JsonExReader::tokenString)
+		{
+			const char* b = nullptr;
+			const char* e = nullptr;
+			std::string s;
+			reader.readStringView(b, e, s);
+			bValid = utils::json_time_parse(b, e, seconds, nanos);
+		}
+		else if (token == JsonExReader::tokenNumber)
+		{
+			JsonExNumber number;
+			reader.readNumber(number);
+			bValid = JsonEpochTime(number, seconds, nanos);
+		}
+		else
+		{
+			err = " -> invalid value type.";
+			return false;
+		}
+		if (!bValid || !utils::json_time_make(seconds, nanos, value))
+		{
+			err = " -> invalid time value.";
+			return false;
+		}
+		return true;
+	}
+
+	// std::chrono::duration overload json text reading
+	template<typename Rep, typename Period> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::chrono::duration<Rep, Period>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenNumber)
+		{
+			err = " -> invalid value type.";
+			return false;
+		}
+		JsonExNumber number;
+		reader.readNumber(number);
+		Rep count = Rep();
+		if (!JsonNumberAs(number, count, std::is_floating_point<Rep>()))
+		{
+			err = " -> invalid value.";
+			return false;
+		}
+		value = std::chrono::duration<Rep, Period>(count);
+		return true;
+	}
+
+	// enum overload json text reading, names without escapes are found in the text directly
+	template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+	static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, T& value)
+	{
+		if (reader.peek() != JsonExReader::tokenString)
+		{
+			err = " -> invalid value type.";
+			return false;
+		}
+		const char* b = nullptr;
+		const char* e = nullptr;
+		std::string s;
+		reader.readStringView(b, e, s);
+		if (JsonExEnumTraits<T>::names().find(b, e - b, value)) return true;
+		err = " -> unknown enum name '" + std::string(b, e) + "'.";
+		return false;
+	}
+
+	// utils::SmallVector<T, N> and utils::BoundedVector<T, N> overload json text reading
+	template<typename T, size_t N, bool bGrow> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, utils::InlineVector<T, N, bGrow>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be array.";
+			return false;
+		}
+		value.clear();
+		size_t count = 0;
+		if (reader.beginArray())
+		{
+			do
+			{
+				if (!bGrow && count >= N)
+				{
+					// the rest is counted for the error message only
+					reader.skipValue();
+				}
+				else if (!JsonValueRead(reader, attr, err, value.emplace_back()))
+				{
+					err.insert(0, "[" + std::to_string(count) + "]");
+					return false;
+				}
+				count++;
+			} while (reader.nextElement());
+		}
+		if (!bGrow && count > N)
+		{
+			err = " -> invalid array size " + std::to_string(count) + " > " + std::to_string(N) + ".";
+			return false;
+		}
+		return true;
+	}
+
+	// utils::FixedString<N> overload json text reading, strings without escapes are copied from the text directly
+	template<size_t N> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, utils::FixedString<N>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenString)
+		{
+			err = " -> invalid value type.";
+			return false;
+		}
+		const char* b = nullptr;
+		const char* e = nullptr;
+		std::string s;
+		reader.readStringView(b, e, s);
+		size_t length = e - b;
+		bool bValid = value.try_assign(b, length);
+		if (!bValid) err = " -> invalid string length " + std::to_string(length) + " > " + std::to_string(N) + ".";
+		return bValid;
+	}
+
+	// utils::InternedString overload json text reading, strings without escapes are found by the text directly
+	static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, utils::InternedString& value)
+	{
+		if (reader.peek() != JsonExReader::tokenString)
+		{
+			err = " -> invalid value type.";
+			return false;
+		}
+		const char* b = nullptr;
+		const char* e = nullptr;
+		std::string s;
+		reader.readStringView(b, e, s);
+		try
+		{
+			value = utils::InternedString(b, e - b);
+		}
+		catch (std::length_error&)
+		{
+			err = " -> too many interned strings.";
+			return false;
+		}
+		return true;
+	}
+
+	// JsonExProducer<T> overload json text reading, the items are kept in the vector
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, JsonExProducer<T>& value)
+	{
+		std::vector<T> items;
+		if (!JsonValueRead(reader, attr, err, items)) return false;
+		value = JsonExProducer<T>(std::move(items));
+		return true;
+	}
+
+	// JsonExConsumer<T> overload json text reading, each item is passed to the consumer as soon as it is read
+	template<typename T> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, JsonExConsumer<T>& value)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be array.";
+			return false;
+		}
+		value.reset();
+		if (!reader.beginArray()) return true;
+		size_t i = 0;
+		do
+		{
+			T item;
+			if (!JsonValueRead(reader, attr, err, item))
+			{
+				err.insert(0, "[" + std::to_string(i) + "]");
+				return false;
+			}
+			if (!value.consume(std::move(item)))
+			{
+				err = "[" + std::to_string(i) + "] -> stopped by the consumer.";
+				return false;
+			}
+			i++;
+		} while (reader.nextElement());
+		return true;
+	}
+
+	// std::map<std::string, T> overload json text reading
+	template<typename T, typename C, typename A> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::map<std::string, T, C, A>& value)
+	{
+		return JsonObjectRead(reader, attr, err, value);
+	}
+
+	// std::unordered_map<std::string, T> overload json text reading
+	template<typename T, typename H, typename E, typename A> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, std::unordered_map<std::string, T, H, E, A>& value)
+	{
+		return JsonObjectRead(reader, attr, err, value);
+	}
+
+	// utils::FlatMap<std::string, T> overload json text reading
+	template<typename T, typename C> static bool JsonValueRead(JsonExReader& reader, const attr_type& attr, std::string& err, utils::FlatMap<std::string, T, C>& value)
+	{
+		return JsonObjectRead(reader, attr, err, value);
+	}
+
+	// json object with any keys reading into associative container
+	template<typename M> static bool JsonObjectRead(JsonExReader& reader, const attr_type& attr, std::string& err, M& value)
+	{
+		if (reader.peek() != JsonExReader::tokenObject)
+		{
+			err = " -> invalid type, must be object.";
+			return false;
+		}
+		// containers of shared values compare the items with the previous items of the same key
+		M previous;
+		if (JsonExHoldsShared<M>::value) previous = std::move(value);
+		value.clear();
+		if (!reader.beginObject()) return true;
+		do
+		{
+			std::string key;
+			reader.readKey(key);
+			typename M::mapped_type v;
+			JsonItemPrepare(v, previous, key);
+			if (!JsonValueRead(reader, attr, err, v))
+			{
+				err.insert(0, "." + key);
+				return false;
+			}
+			JsonMapEmplace(value, std::move(key), std::move(v));
+		} while (reader.nextMember());
+		JsonMapFinish(value);
+		return true;
+	}
+
+	// the shared item is taken from the previous container to be compared with the new text
+	template<typename T, typename M> static void JsonItemPrepare(JsonExShared<T>& item, const M& previous, const std::string& key)
+	{
+		typename M::const_iterator it = previous.find(key);
+		if (it != previous.end()) item = it->second;
+	}
+
+	// other items are read anew
+	template<typename T, typename M> static void JsonItemPrepare(T&, const M&, const std::string&)
+	{
+	}
+
+public:
+	template<typename T, typename std::enable_if<!(std::is_base_of<JsonExBase, T>::value || std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_same<T, std::string>::value)>::type * = nullptr>
+	// main json creation template method
+	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T&)
+	{
+		static_assert(false, "Json creation for this type not implemented");
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	// json creation for JsonExBase based types/subtypes template method
+	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T& obj)
+	{
+		return T::JsonCreate(json, obj, err);
+	}
+
+	// utils::Nullable<T> overload json value create
+	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::Nullable<T>& obj)
+	{
+		if (!obj)
+		{
+			json = Json::Value::nullSingleton();
+			return true;
+		}
+		return JsonValueCreate(json, attr, err, obj.value());
+	}
+
+	// JsonExShared<T> overload json value create
+	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExShared<T>& value)
+	{
+		if (!value)
+		{
+			json = Json::Value::nullSingleton();
+			return true;
+		}
+		return JsonValueCreate(json, attr, err, value.get());
+	}
+
+	template<typename T, typename std::enable_if< std::is_arithmetic<T>::value || std::is_same<T, std::string>::value>::type * = nullptr>
+	// json creation for arithmetic and string types template method
+	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T& value)
+	{
+		json = Json::Value(value);
+		return true;
+	}
+
+	// vector<T> overload json value create
+	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::vector<T>& value)
+	{
+		Json::Value jsonV(Json::arrayValue);
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			std::ostringstream ss;
+			Json::Value v;
+			if (JsonValueCreate(v, attr, ss, value[i]))
+			{
+				jsonV.append(std::move(v));
+			}
+			else
+			{
+				err << "[" << i << "]" << ss.str();
+				return false;
+			}
+		}
+		json.swap(jsonV);
+		return true;
+	}
+
+	// fixed size array overload json value create
+	template<typename T, size_t Size> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::array<T, Size>& value)
+	{
+		Json::Value jsonV(Json::arrayValue);
 		//for (const T& item : value)
 		for (size_t i = 0; i < Size; i++)
 		{
-			std::ostringstream ss;
-			Json::Value v;
-			if (JsonValueCreate(v, attr, ss, value[i]))
+			std::ostringstream ss;
+			Json::Value v;
+			if (JsonValueCreate(v, attr, ss, value[i]))
+			{
+				jsonV.append(std::move(v));
+			}
+			else
+			{
+				err << "[" << i << "]" << ss.str();
+				return false;
+			}
+		}
+		json.swap(jsonV);
+		return true;
+	}
+
+	// JsonExVariant overload json value create, empty variant is created as null
+	template<typename K, typename... Ts> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExVariant<K, Ts...>& value)
+	{
+		if (value.empty())
+		{
+			json = Json::Value();
+			return true;
+		}
+		typedef bool (*create_type)(Json::Value&, const attr_type&, std::ostream&, const JsonExVariant<K, Ts...>&);
+		static const create_type creators[] = { &JsonVariantCreate<Ts, K, Ts...>... };
+		return creators[value.index()](json, attr, err, value);
+	}
+
+	template<typename T, typename K, typename... Ts> static bool JsonVariantCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExVariant<K, Ts...>& value)
+	{
+		const T& obj = value.template get<T>();
+		if (!JsonExVariantKey<K, T>::matches(obj, JsonExDataTraits<T>::discriminator()))
+		{
+			err << "." << K::name() << " -> discriminator does not match '" << JsonExDataTraits<T>::discriminator() << "'.";
+			return false;
+		}
+		return JsonValueCreate(json, attr, err, obj);
+	}
+
+	// system_clock::time_point overload json value create, RFC 3339 UTC string
+	template<typename D> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::chrono::time_point<std::chrono::system_clock, D>& value)
+	{
+		long long seconds = 0;
+		long nanos = 0;
+		utils::json_time_split(value, seconds, nanos);
+		char buffer[utils::json_time_size];
+		size_t size = utils::json_time_format(buffer, seconds, nanos);
+		if (!size)
+		{
+			err << " -> invalid time value.";
+			return false;
+		}
+		json = Json::Value(buffer, buffer + size);
+		return true;
+	}
+
+	// std::chrono::duration overload json value create, number of the duration's units
+	template<typename Rep, typename Period> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::chrono::duration<Rep, Period>& value)
+	{
+		json = std::is_floating_point<Rep>::value ? Json::Value(static_cast<double>(value.count())) :
+			std::is_signed<Rep>::value ? Json::Value(static_cast<Json::Int64>(value.count())) : Json::Value(static_cast<Json::UInt64>(value.count()));
+		return true;
+	}
+
+	// enum overload json value create, the json value refers to the name of the table without copying
+	template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const T& value)
+	{
+		const std::string* name = JsonExEnumTraits<T>::names().name(value);
+		if (!name)
+		{
+			err << " -> invalid enum value " << static_cast<long long>(value) << ".";
+			return false;
+		}
+		json = Json::Value(Json::StaticString(name->c_str()));
+		return true;
+	}
+
+	// utils::SmallVector<T, N> and utils::BoundedVector<T, N> overload json value create
+	template<typename T, size_t N, bool bGrow> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::InlineVector<T, N, bGrow>& value)
+	{
+		Json::Value jsonV(Json::arrayValue);
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			std::ostringstream ss;
+			Json::Value v;
+			if (!JsonValueCreate(v, attr, ss, value[i]))
+			{
+				err << "[" << i << "]" << ss.str();
+				return false;
+			}
+			jsonV.append(std::move(v));
+		}
+		json.swap(jsonV);
+		return true;
+	}
+
+	// utils::FixedString<N> overload json value create
+	template<size_t N> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::FixedString<N>& value)
+	{
+		json = Json::Value(value.data(), value.data() + value.size());
+		return true;
+	}
+
+	// utils::InternedString overload json value create
+	static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::InternedString& value)
+	{
+		json = Json::Value(value.data(), value.data() + value.size());
+		return true;
+	}
+
+	// JsonExProducer<T> overload json value create, json array needs all the items anyway
+	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExProducer<T>& value)
+	{
+		std::vector<T> items;
+		typename JsonExProducer<T>::producer_type producer = value.producer();
+		T item;
+		while (producer && producer(item)) items.push_back(std::move(item));
+		return JsonValueCreate(json, attr, err, items);
+	}
+
+	// JsonExConsumer<T> overload json value create, the items are not kept
+	template<typename T> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const JsonExConsumer<T>&)
+	{
+		json = Json::Value(Json::arrayValue);
+		return true;
+	}
+
+	// std::map<std::string, T> overload json value create
+	template<typename T, typename C, typename A> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::map<std::string, T, C, A>& value)
+	{
+		return JsonObjectCreate(json, attr, err, value);
+	}
+
+	// std::unordered_map<std::string, T> overload json value create
+	template<typename T, typename H, typename E, typename A> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const std::unordered_map<std::string, T, H, E, A>& value)
+	{
+		return JsonObjectCreate(json, attr, err, value);
+	}
+
+	// utils::FlatMap<std::string, T> overload json value create
+	template<typename T, typename C> static bool JsonValueCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const utils::FlatMap<std::string, T, C>& value)
+	{
+		return JsonObjectCreate(json, attr, err, value);
+	}
+
+	// json object creation from associative container
+	template<typename M> static bool JsonObjectCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const M& value)
+	{
+		Json::Value jsonV(Json::objectValue);
+		std::ostringstream ss;
+		for (const typename M::value_type& item: value)
+		{
+			if (!JsonValueCreate(jsonV[item.first], attr, ss, item.second))
+			{
+				err << "." << item.first << ss.str();
+				return false;
+			}
+		}
+		json.swap(jsonV);
+		return true;
+	}
+
+public:
+	// Json text writing methods report errors into the string, nested methods prepend the path of the failed value.
+
+	template<typename T, typename std::enable_if<!(std::is_base_of<JsonExBase, T>::value || std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_same<T, std::string>::value)>::type * = nullptr>
+	// main json text writing template method
+	static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const T&)
+	{
+		static_assert(false, "Json writing for this type not implemented");
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	// json text writing for JsonExBase based types/subtypes template method
+	static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const T& obj)
+	{
+		return T::JsonWrite(writer, obj, err);
+	}
+
+	// utils::Nullable<T> overload json text writing
+	template<typename T> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const utils::Nullable<T>& obj)
+	{
+		if (!obj)
+		{
+			writer.writeNull();
+			return true;
+		}
+		return JsonValueWrite(writer, attr, err, obj.value());
+	}
+
+	// JsonExShared<T> overload json text writing
+	template<typename T> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const JsonExShared<T>& value)
+	{
+		if (!value)
+		{
+			writer.writeNull();
+			return true;
+		}
+		return JsonValueWrite(writer, attr, err, value.get());
+	}
+
+	template<typename T, typename std::enable_if< std::is_arithmetic<T>::value || std::is_same<T, std::string>::value>::type * = nullptr>
+	// json text writing for arithmetic and string types template method
+	static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const T& value)
+	{
+		writer.write(value);
+		return true;
+	}
+
+	// vector<T> overload json text writing
+	template<typename T> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::vector<T>& value)
+	{
+		writer.writeChar('[');
+		if (!JsonItemsWrite(writer, attr, err, value, ',')) return false;
+		writer.writeChar(']');
+		return true;
+	}
+
+	// writes the items with the separator between them.
+	// If the writer has a pool, large vectors are split into chunks written in parallel into separate buffers,
+	// then the buffers are joined in the items order.
+	template<typename T> static bool JsonItemsWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::vector<T>& value, char separator)
+	{
+		utils::ThreadPool* pool = writer.pool();
+		size_t chunks = pool ? std::min(value.size() / JsonExWriter::parallelChunkSize, (pool->size() + 1) * 4) : 0;
+		if (chunks < 2)
+		{
+			for (size_t i = 0; i < value.size(); i++)
+			{
+				if (i) writer.writeChar(separator);
+				if (!JsonValueWrite(writer, attr, err, value[i]))
+				{
+					err.insert(0, "[" + std::to_string(i) + "]");
+					return false;
+				}
+				writer.flushChunk();
+			}
+			return true;
+		}
+
+		std::vector<std::string> buffers(chunks);
+		std::vector<std::string> errors(chunks);
+		std::vector<char> results(chunks, 0);
+		pool->parallel_for(chunks, [&](size_t c)
+		{
+			size_t begin = value.size() * c / chunks;
+			size_t end = value.size() * (c + 1) / chunks;
+			// the chunk writer has no pool, so nested vectors are written sequentially
+			JsonExWriter chunkWriter(buffers[c]);
+			chunkWriter.setShared(writer.isShared());
+			for (size_t i = begin; i < end; i++)
+			{
+				if (i != begin) chunkWriter.writeChar(separator);
+				if (!JsonValueWrite(chunkWriter, attr, errors[c], value[i]))
+				{
+					errors[c].insert(0, "[" + std::to_string(i) + "]");
+					return;
+				}
+			}
+			results[c] = 1;
+		});
+
+		size_t size = writer.buffer().size() + chunks;
+		for (size_t c = 0; c < chunks; c++)
+		{
+			if (!results[c])
+			{
+				err = errors[c];
+				return false;
+			}
+			size += buffers[c].size();
+		}
+		writer.buffer().reserve(size);
+		for (size_t c = 0; c < chunks; c++)
+		{
+			if (c) writer.writeChar(separator);
+			writer.writeRaw(buffers[c]);
+		}
+		return true;
+	}
+
+	// fixed size array overload json text writing
+	template<typename T, size_t Size> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::array<T, Size>& value)
+	{
+		writer.writeChar('[');
+		for (size_t i = 0; i < Size; i++)
+		{
+			if (i) writer.writeChar(',');
+			if (!JsonValueWrite(writer, attr, err, value[i]))
+			{
+				err.insert(0, "[" + std::to_string(i) + "]");
+				return false;
+			}
+		}
+		writer.writeChar(']');
+		return true;
+	}
+
+	// JsonExVariant overload json text writing, empty variant is written as null
+	template<typename K, typename... Ts> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const JsonExVariant<K, Ts...>& value)
+	{
+		if (value.empty())
+		{
+			writer.writeNull();
+			return true;
+		}
+		typedef bool (*write_type)(JsonExWriter&, const attr_type&, std::string&, const JsonExVariant<K, Ts...>&);
+		static const write_type writers[] = { &JsonVariantWrite<Ts, K, Ts...>... };
+		return writers[value.index()](writer, attr, err, value);
+	}
+
+	template<typename T, typename K, typename... Ts> static bool JsonVariantWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const JsonExVariant<K, Ts...>& value)
+	{
+		const T& obj = value.template get<T>();
+		if (!JsonExVariantKey<K, T>::matches(obj, JsonExDataTraits<T>::discriminator()))
+		{
+			err = "." + std::string(K::name()) + " -> discriminator does not match '" + JsonExDataTraits<T>::discriminator() + "'.";
+			return false;
+		}
+		return JsonValueWrite(writer, attr, err, obj);
+	}
+
+	// system_clock::time_point overload json text writing, RFC 3339 UTC string
+	template<typename D> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::chrono::time_point<std::chrono::system_clock, D>& value)
+	{
+		long long seconds = 0;
+		long nanos = 0;
+		utils::json_time_split(value, seconds, nanos);
+		char buffer[utils::json_time_size];
+		size_t size = utils::json_time_format(buffer, seconds, nanos);
+		if (!size)
+		{
+			err = " -> invalid time value.";
+			return false;
+		}
+		// the date-time has no chars to escape
+		writer.writeChar('"');
+		writer.writeRaw(buffer, size);
+		writer.writeChar('"');
+		return true;
+	}
+
+	// std::chrono::duration overload json text writing, number of the duration's units
+	template<typename Rep, typename Period> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::chrono::duration<Rep, Period>& value)
+	{
+		writer.write(value.count());
+		return true;
+	}
+
+	// enum overload json text writing, the name is quoted and escaped once for the table
+	template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+	static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const T& value)
+	{
+		const std::string* literal = JsonExEnumTraits<T>::names().literal(value);
+		if (!literal)
+		{
+			err = " -> invalid enum value " + std::to_string(static_cast<long long>(value)) + ".";
+			return false;
+		}
+		writer.writeRaw(*literal);
+		return true;
+	}
+
+	// utils::SmallVector<T, N> and utils::BoundedVector<T, N> overload json text writing
+	template<typename T, size_t N, bool bGrow> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const utils::InlineVector<T, N, bGrow>& value)
+	{
+		writer.writeChar('[');
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			if (i) writer.writeChar(',');
+			if (!JsonValueWrite(writer, attr, err, value[i]))
+			{
+				err.insert(0, "[" + std::to_string(i) + "]");
+				return false;
+			}
+		}
+		writer.writeChar(']');
+		return true;
+	}
+
+	// utils::FixedString<N> overload json text writing
+	template<size_t N> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const utils::FixedString<N>& value)
+	{
+		writer.writeString(value.data(), value.size());
+		return true;
+	}
+
+	// utils::InternedString overload json text writing, the interned strings are never freed, so long ones can be referenced
+	static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const utils::InternedString& value)
+	{
+		writer.write(value.str());
+		return true;
+	}
+
+	// JsonExProducer<T> overload json text writing.
+	// The items are written as they are produced, the text is passed to the writer's sink by chunks.
+	template<typename T> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const JsonExProducer<T>& value)
+	{
+		if (writer.isSizing())
+		{
+			err = " -> produced items can not be sized.";
+			return false;
+		}
+		typename JsonExProducer<T>::producer_type producer = value.producer();
+		// the produced item is temporary, so its strings are copied
+		bool bReferencing = writer.isReferencing();
+		writer.setReferencing(false);
+		writer.writeChar('[');
+		T item;
+		for (size_t i = 0; producer && producer(item); i++)
+		{
+			if (i) writer.writeChar(',');
+			if (!JsonValueWrite(writer, attr, err, item))
+			{
+				err.insert(0, "[" + std::to_string(i) + "]");
+				writer.setReferencing(bReferencing);
+				return false;
+			}
+			writer.flushChunk();
+		}
+		writer.writeChar(']');
+		writer.setReferencing(bReferencing);
+		return true;
+	}
+
+	// JsonExConsumer<T> overload json text writing, the items are not kept
+	template<typename T> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const JsonExConsumer<T>&)
+	{
+		writer.writeChar('[');
+		writer.writeChar(']');
+		return true;
+	}
+
+	// std::map<std::string, T> overload json text writing, maps with other keys order are written sorted
+	template<typename T, typename C, typename A> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::map<std::string, T, C, A>& value)
+	{
+		return JsonKeyOrdered<C>::value ? JsonObjectWrite(writer, attr, err, value) : JsonSortedObjectWrite(writer, attr, err, value);
+	}
+
+	// std::unordered_map<std::string, T> overload json text writing
+	template<typename T, typename H, typename E, typename A> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const std::unordered_map<std::string, T, H, E, A>& value)
+	{
+		return JsonSortedObjectWrite(writer, attr, err, value);
+	}
+
+	// utils::FlatMap<std::string, T> overload json text writing, maps with other keys order are written sorted
+	template<typename T, typename C> static bool JsonValueWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const utils::FlatMap<std::string, T, C>& value)
+	{
+		return JsonKeyOrdered<C>::value ? JsonObjectWrite(writer, attr, err, value) : JsonSortedObjectWrite(writer, attr, err, value);
+	}
+
+	// json object text writing from associative container in the sorted keys order,
+	// so the text is the same as Json::Value writing produces
+	template<typename M> static bool JsonSortedObjectWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const M& value)
+	{
+		typedef typename M::value_type item_type;
+		std::vector<const item_type*> items;
+		items.reserve(value.size());
+		for (const item_type& item: value) items.push_back(&item);
+		std::sort(items.begin(), items.end(), [](const item_type* op1, const item_type* op2) { return op1->first < op2->first; });
+
+		writer.writeChar('{');
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			if (!JsonMemberWrite(writer, attr, err, i == 0, items[i]->first, items[i]->second)) return false;
+		}
+		writer.writeChar('}');
+		return true;
+	}
+
+	// json object text writing from associative container ordered the same as json object keys
+	template<typename M> static bool JsonObjectWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const M& value)
+	{
+		writer.writeChar('{');
+		bool bFirst = true;
+		for (const typename M::value_type& item: value)
+		{
+			if (!JsonMemberWrite(writer, attr, err, bFirst, item.first, item.second)) return false;
+			bFirst = false;
+		}
+		writer.writeChar('}');
+		return true;
+	}
+
+	// json object member text writing, the key is prepended to the error path
+	template<typename T> static bool JsonMemberWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, bool bFirst, const std::string& key, const T& value)
+	{
+		if (!bFirst) writer.writeChar(',');
+		writer.writeString(key);
+		writer.writeChar(':');
+		if (!JsonValueWrite(writer, attr, err, value))
+		{
+			err.insert(0, "." + key);
+			return false;
+		}
+		return true;
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	// merge patch of JsonEx based sub object contains only its changed fields
+	static bool JsonValueWritePatch(JsonExWriter& writer, const attr_type& attr, std::string& err, const T& obj)
+	{
+		return T::JsonWriteMergePatch(writer, obj, err);
+	}
+
+	template<typename T, typename std::enable_if< !std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	// values of other types are replaced by merge patch as a whole
+	static bool JsonValueWritePatch(JsonExWriter& writer, const attr_type& attr, std::string& err, const T& value)
+	{
+		return JsonValueWrite(writer, attr, err, value);
+	}
+
+	// writes merge patch changing the previous json value to the new one: missing members are removed by null,
+	// changed members of both objects are written as nested patches, equal members are not written
+	static void JsonMergeDiffWrite(JsonExWriter& writer, const Json::Value& previous, const Json::Value& value)
+	{
+		if (!previous.isObject() || !value.isObject())
+		{
+			writer.writeValue(value);
+			return;
+		}
+		writer.writeChar('{');
+		bool bFirst = true;
+		for (Json::Value::const_iterator it = previous.begin(); it != previous.end(); ++it)
+		{
+			const char* end = nullptr;
+			const char* name = it.memberName(&end);
+			if (value.find(name, end)) continue;
+			if (!bFirst) writer.writeChar(',');
+			bFirst = false;
+			writer.writeString(name, end - name);
+			writer.writeChar(':');
+			writer.writeNull();
+		}
+		for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+		{
+			const char* end = nullptr;
+			const char* name = it.memberName(&end);
+			const Json::Value* member = previous.find(name, end);
+			if (member && *member == *it) continue;
+			if (!bFirst) writer.writeChar(',');
+			bFirst = false;
+			writer.writeString(name, end - name);
+			writer.writeChar(':');
+			if (member) JsonMergeDiffWrite(writer, *member, *it);
+			else writer.writeValue(*it);
+		}
+		writer.writeChar('}');
+	}
+
+	// unknown members of json object are added to the created json object
+	static void JsonExtrasCreate(Json::Value& root, const JsonExExtras& extras)
+	{
+		const std::string& text = extras.text();
+		for (size_t i = 0; i < extras.size(); i++)
+		{
+			const JsonExExtras::Member& m = extras.members()[i];
+			JsonExReader reader(text.data() + m.valueBegin, text.data() + m.valueEnd);
+			reader.readValue(root[extras.key(i)]);
+		}
+	}
+
+public:
+	// table of the field type's methods, one per field type for all JsonEx types
+	template<typename T> static const JsonExFieldCodec& FieldCodec()
+	{
+		static const JsonExFieldCodec codec =
+		{
+			&FieldValidate<T>, &FieldParse<T>, &FieldCreate<T>, &FieldWrite<T>, &FieldWritePatch<T>, &FieldRead<T>, &FieldClearDirty<T>,
+			FieldPrepare(static_cast<T*>(nullptr)), JsonExMergedObject<T>::value
+		};
+		return codec;
+	}
+
+protected:
+	template<typename T> static bool FieldValidate(const Json::Value& json, const attr_type& attr, std::ostream& err)
+	{
+		// to call JsonTypeValidate we need only type, not actual value
+		return JsonTypeValidate(json, attr, err, *static_cast<const T*>(nullptr));
+	}
+
+	template<typename T> static bool FieldParse(const Json::Value& json, const attr_type& attr, std::ostream& err, void* value)
+	{
+		return JsonValueParse(json, attr, err, *static_cast<T*>(value));
+	}
+
+	template<typename T> static bool FieldCreate(Json::Value& json, const attr_type& attr, std::ostream& err, const void* value)
+	{
+		return JsonValueCreate(json, attr, err, *static_cast<const T*>(value));
+	}
+
+	template<typename T> static bool FieldWrite(JsonExWriter& writer, const attr_type& attr, std::string& err, const void* value)
+	{
+		return JsonValueWrite(writer, attr, err, *static_cast<const T*>(value));
+	}
+
+	template<typename T> static bool FieldWritePatch(JsonExWriter& writer, const attr_type& attr, std::string& err, const void* value)
+	{
+		return JsonValueWritePatch(writer, attr, err, *static_cast<const T*>(value));
+	}
+
+	template<typename T> static bool FieldRead(JsonExReader& reader, const attr_type& attr, std::string& err, void* value)
+	{
+		return JsonValueRead(reader, attr, err, *static_cast<T*>(value));
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	static void FieldClearDirty(void* value)
+	{
+		static_cast<T*>(value)->clearDirty();
+	}
+
+	template<typename T, typename std::enable_if< !std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	static void FieldClearDirty(void*)
+	{
+	}
+
+	typedef void (*field_prepare_fn)(void*, const void*);
+
+	template<typename T> static field_prepare_fn FieldPrepare(JsonExConsumer<T>*)
+	{
+		return &FieldPrepareConsumer<T>;
+	}
+
+	template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+	static field_prepare_fn FieldPrepare(T*)
+	{
+		return &FieldPrepareObject<T>;
+	}
+
+	// JsonExShared fields and containers of them keep the previous values to compare them with the new text
+	template<typename T, typename std::enable_if< JsonExHoldsShared<T>::value>::type * = nullptr>
+	static field_prepare_fn FieldPrepare(T*)
+	{
+		return &FieldPrepareShared<T>;
+	}
+
+	// other types do not need preparing
+	static field_prepare_fn FieldPrepare(...)
+	{
+		return nullptr;
+	}
+
+	template<typename T> static void FieldPrepareConsumer(void* value, const void* source)
+	{
+		static_cast<JsonExConsumer<T>*>(value)->prepare(*static_cast<const JsonExConsumer<T>*>(source));
+	}
+
+	template<typename T> static void FieldPrepareObject(void* value, const void* source)
+	{
+		T::JsonPrepare(*static_cast<T*>(value), *static_cast<const T*>(source));
+	}
+
+	// copies the shared pointers only
+	template<typename T> static void FieldPrepareShared(void* value, const void* source)
+	{
+		*static_cast<T*>(value) = *static_cast<const T*>(source);
+	}
+};
+
+/*
+Usage of the JsonEx class:
+
+//class CSubObjType; // forward declaration required
+//template<> struct Json::JsonExDataTraits<CSubObjType>
+//{
+//	enum data_enum: size_t
+//	{
+//		AttrA = 0, AttrB = 1, AttrV = 2
+//	};
+//
+//	using data_type = std::tuple<int, int, utils::Nullable<std::array<int, 3>> >;
+//	using attr_type = JsonExAttributes::attr_type;
+//	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+//
+//	static const data_attrs& attributes()
+//	{
+//		static const data_attrs attrs
+//		{
+//			{
+//				attr_type(std::string("a")), attr_type(std::string("b")), attr_type(std::string("v"))
+//			}
+//		};
+//		return attrs;
+//	}
+//
+//};
+//class CSubObjType: public Json::JsonEx<CSubObjType>
+//{
+//public:
+//	CSubObjType() = default;
+//	explicit CSubObjType(const data_type& other): base_type(other) {}
+//	explicit CSubObjType(data_type&& other): base_type(std::forward<data_type>(other)) {}
+//};
+//
+//class CMainType; // forward declaration	required
+//template<> struct Json::JsonExDataTraits<CMainType>
+//{
+//	enum data_enum: size_t
+//	{
+//		AttrBoolValue = 0, AttrUIntValue = 1, AttrVec = 2,
+//		AttrObj = 3, AttrVecObj = 4, AttrVecObjFixedSize = 5
+//	};
+//
+//	using data_type = std::tuple<bool, utils::Nullable<unsigned int>, std::vector<int>, utils::Nullable<CSubObjType>, utils::Nullable< std::vector<CSubObjType>>, utils::Nullable< std::array<CSubObjType, 2>> >;
+//	using attr_type = JsonExAttributes::attr_type;
+//
+//	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+//	static const data_attrs& attributes()
+//	{
+//		static const data_attrs attrs
+//		{
+//			{
+//				attr_type(std::string("boolVal")), attr_type(std::string("uintVal")), attr_type(std::string("vec")),
+//				attr_type(std::string("obj")), attr_type(std::string("vecObj")), attr_type(std::string("vecObjFixedSize"))
+//			}
+//		};
+//		return attrs;
+//	}
+//};
+//
+//class CMainType: public Json::JsonEx<CMainType>
+//{
+//public:
+//	CMainType() = default;
+//	explicit CMainType(const data_type& other): base_type(other) {}
+//	explicit CMainType(data_type&& other): base_type(std::forward<data_type>(other)) {}
+//};
+//
+Code to use:
+
+CMainType mainType;
+bool b = mainType.load(jsonString);
+std::string s = mainType.getJsonString();
+*/
+
+// columnar decoding of JsonEx objects, defined in jsonex_columnar.h
+template<typename _ImplT> class JsonExColumns;
+
+template<typename _ImplT, typename _Dt = JsonExDataTraits<_ImplT> >
+class JsonEx: public JsonExBase
+{
+	template<typename> friend class JsonExColumns;
+
+public:
+	typedef _ImplT main_type;
+	typedef JsonEx base_type;
+	typedef _Dt data_traits;
+
+	// tuple data type
+	typedef typename data_traits::data_type data_type;
+	// array of atributes for the data types
+	typedef typename data_traits::data_attrs data_attrs;
+	// enum to access data typle
+	typedef typename data_traits::data_enum data_enum;
+	// predefined attributes class
+	typedef JsonExAttributes attr_traits;
+	// attributes tuple type
+	typedef typename attr_traits::attr_type attr_type;
+	// enum to access attributes tuple
+	typedef typename attr_traits::attr_enum attr_enum;
+	// set of flags for each tuple's field
+	typedef std::bitset<std::tuple_size<data_type>::value> data_bits;
+	// unknown members of json object are kept and written back
+	static const bool keep_extras = JsonExKeepExtras<data_traits>::value;
+
+	static_assert(std::tuple_size<data_type>::value == std::tuple_size<data_attrs>::value, "invalid data_attrs array size");
+	static_assert(std::is_enum<data_enum>::value, "invalid data_enum type");
+	static_assert(std::is_enum<attr_enum>::value, "invalid attr_enum type");
+
+public:
+	JsonEx() = default;
+	explicit JsonEx(const data_type& other): data_(other) {}
+	explicit JsonEx(data_type&& other): data_(std::forward<data_type>(other)) {}
+	JsonEx(const JsonEx& other): JsonExBase(other), data_(other.data_), extras_(other.extras_), errorInfo_(other.errorInfo_),
+		dirty_(other.dirty_), replaced_(other.replaced_), merged_(other.merged_), cache_(other.cache_ ? new JsonExCache(*other.cache_) : nullptr) {}
+	JsonEx(JsonEx&& other) noexcept: JsonExBase(std::move(other)), data_(std::move(other.data_)), extras_(std::move(other.extras_)), errorInfo_(std::move(other.errorInfo_)),
+		dirty_(other.dirty_), replaced_(other.replaced_), merged_(std::move(other.merged_)), cache_(std::move(other.cache_)) {}
+	~JsonEx() override = default;
+
+	JsonEx& operator=(const JsonEx& other)
+	{
+		if (this != &other)
+		{
+			JsonExBase::operator=(other);
+			data_ = other.data_;
+			extras_ = other.extras_;
+			errorInfo_ = other.errorInfo_;
+			dirty_ = other.dirty_;
+			replaced_ = other.replaced_;
+			merged_ = other.merged_;
+			cache_.reset(other.cache_ ? new JsonExCache(*other.cache_) : nullptr);
+		}
+		return *this;
+	}
+	JsonEx& operator=(JsonEx&& other) noexcept
+	{
+		if (this != &other)
+		{
+			JsonExBase::operator=(std::move(other));
+			data_ = std::move(other.data_);
+			extras_ = std::move(other.extras_);
+			errorInfo_ = std::move(other.errorInfo_);
+			dirty_ = other.dirty_;
+			replaced_ = other.replaced_;
+			merged_ = std::move(other.merged_);
+			cache_ = std::move(other.cache_);
+		}
+		return *this;
+	}
+
+	// static object types validation for json object
+	static bool JsonValidate(const Json::Value &root, std::ostream& err)
+	{
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		std::ostringstream ss;
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			const std::string& name = std::get<attr_enum::AttrIndexName>(attrs[i]);
+			if (!fields[i].codec->validate(root[name], attrs[i], ss))
+			{
+				err << "." << name << ss.str();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// parse input json object into output JsonEx specialized object
+	static bool JsonParse(const Json::Value &root, JsonEx& obj, std::ostream& err)
+	{
+		std::ostringstream ss;
+		bool bValid = JsonValidate(root, ss);
+		if (!bValid)
+		{
+			err << ss.str();
+			return false;
+		}
+		ss = std::ostringstream();
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		size_t iInvalidField = 0;
+		while (iInvalidField < fields.size() &&
+			fields[iInvalidField].codec->parse(root[std::get<attr_enum::AttrIndexName>(attrs[iInvalidField])], attrs[iInvalidField], ss, JsonFieldValue(obj.data_, iInvalidField)))
+		{
+			iInvalidField++;
+		}
+		obj.markAllDirty();
+		bValid = iInvalidField >= fields.size();
+		if (!bValid)
+		{
+			err << "." << std::get<attr_enum::AttrIndexName>(attrs[iInvalidField]) << ss.str();
+			return false;
+		}
+		obj.extras_.clear();
+		if (keep_extras && root.isObject()) JsonExtrasParse(root, obj.extras_);
+		return bValid;
+	}
+
+	// reads the object directly from json text, without json object creation.
+	// Missing fields are read as json null values, unknown members are skipped or kept as extras.
+	// The object is changed only if all the fields are read successfully.
+	static bool JsonRead(JsonExReader& reader, JsonEx& obj, std::string& err)
+	{
+		if (reader.peek() != JsonExReader::tokenObject)
+		{
+			err = " -> invalid type, must be object.";
+			return false;
+		}
+
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		data_type data;
+		JsonPrepareData(data, obj.data_);
+		JsonExExtras extras;
+		data_bits found;
+		std::string scratch;
+		std::string value;
+		if (reader.beginObject())
+		{
+			do
+			{
+				const char* b = nullptr;
+				const char* e = nullptr;
+				reader.readKey(b, e, scratch);
+				size_t i = JsonFieldFind(b, e);
+				if (i < found.size())
+				{
+					if (!fields[i].codec->read(reader, attrs[i], err, JsonFieldValue(data, i)))
+					{
+						err.insert(0, "." + std::get<attr_enum::AttrIndexName>(attrs[i]));
+						return false;
+					}
+					found.set(i);
+				}
+				else if (keep_extras)
+				{
+					// the value's text is kept without white spaces and comments, as json object writes it
+					value.clear();
+					reader.copyValue(value);
+					extras.append(b, e - b, value.data(), value.size());
+				}
+				else
+				{
+					reader.skipValue();
+				}
+			} while (reader.nextMember());
+		}
+
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			if (found.test(i)) continue;
+			static const char null[] = "null";
+			JsonExReader nullReader(null, null + sizeof(null) - 1);
+			if (!fields[i].codec->read(nullReader, attrs[i], err, JsonFieldValue(data, i)))
 			{
-				jsonV.append(std::move(v));
+				err.insert(0, "." + std::get<attr_enum::AttrIndexName>(attrs[i]));
+				return false;
 			}
-			else
+		}
+
+		obj.data_ = std::move(data);
+		obj.extras_ = std::move(extras);
+		obj.markAllDirty();
+		return true;
+	}
+
+	// copies consumers and shared values of the fields from the source object before reading of the object
+	static void JsonPrepare(JsonEx& obj, const JsonEx& source)
+	{
+		JsonPrepareData(obj.data_, source.data_);
+	}
+
+	// creates json object from input JsonEx specialized object
+	static bool JsonCreate(Json::Value &root, const JsonEx& obj, std::ostream& err)
+	{
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		std::ostringstream ss;
+		Json::Value jsonObj(Json::objectValue);
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			const std::string& name = std::get<attr_enum::AttrIndexName>(attrs[i]);
+			if (!fields[i].codec->create(jsonObj[name], attrs[i], ss, JsonFieldValue(obj.data_, i)))
 			{
-				err << "[" << i << "]" << ss.str();
+				err << "." << name << ss.str();
 				return false;
 			}
 		}
-		json.swap(jsonV);
+		JsonExCodec::JsonExtrasCreate(jsonObj, obj.extras_);
+		root = jsonObj;
 		return true;
 	}
 
-	template<typename _Tt>
-	// functor to call tuple creation
-	struct FnValueCreate
+	// writes compact json text of the object directly, without json object creation.
+	// If caching is enabled, the text of the unchanged fields is copied from the cache.
+	static bool JsonWrite(JsonExWriter& writer, const JsonEx& obj, std::string& err)
 	{
-		FnValueCreate(Json::Value &root, const data_attrs& names, std::ostream& err): root_(root), names_(names), err_(err) {}
+		if (!obj.cache_) return JsonWriteObject(writer, obj, nullptr, err);
 
-		template<typename T, size_t _Index> bool operator() (std::integral_constant<size_t, _Index>, const T& value) const
+		JsonExCache& cache = *obj.cache_;
+		if (cache.stale.any())
 		{
-			const attr_type& attr = std::get<_Index>(names_);
-			bool bValid = JsonValueCreate(root_[std::get<attr_enum::AttrIndexName>(attr)], attr, err_, value);
-			return !bValid;
-		};
+			// shared object is written without the cache, so the cache is not changed
+			if (writer.isShared()) return JsonWriteObject(writer, obj, nullptr, err);
+
+			// rebuild the cached text, the text of unchanged fields is taken from the previous one
+			std::string bytes;
+			bytes.reserve(cache.bytes.size());
+			JsonExWriter cacheWriter(bytes, writer.pool());
+			if (!JsonWriteObject(cacheWriter, obj, &cache, err)) return false;
+			cache.bytes.swap(bytes);
+			cache.stale.reset();
+		}
+		writer.writeRawRef(cache.bytes.data(), cache.bytes.size());
+		return true;
+	}
+
+	// writes compact json array of the objects.
+	// If the writer has a pool, chunks of the array are written in parallel, the output is the same.
+	static bool JsonWriteArray(JsonExWriter& writer, const std::vector<main_type>& items, std::string& err)
+	{
+		writer.writeChar('[');
+		if (!JsonExCodec::JsonItemsWrite(writer, attr_type(), err, items, ',')) return false;
+		writer.writeChar(']');
+		return true;
+	}
+
+	// writes newline delimited json, one compact object per line.
+	// If the writer has a pool, chunks of the lines are written in parallel, the output is the same.
+	static bool JsonWriteLines(JsonExWriter& writer, const std::vector<main_type>& items, std::string& err)
+	{
+		if (!JsonExCodec::JsonItemsWrite(writer, attr_type(), err, items, '\n')) return false;
+		if (!items.empty()) writer.writeChar('\n');
+		return true;
+	}
+
+	// writes RFC 7386 json merge patch, which contains only fields changed since the last clearDirty() call.
+	// Changed JsonEx sub objects modified in place are written as nested patches. Changed maps and variants are written
+	// as patches of their value at the last clearDirty() call, as a whole if it was not called.
+	static bool JsonWriteMergePatch(JsonExWriter& writer, const JsonEx& obj, std::string& err)
+	{
+		const field_keys& keys = JsonFieldKeys();
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+
+		writer.writeChar('{');
+		bool bFirst = true;
+		for (size_t i: JsonFieldOrder())
+		{
+			if (!obj.dirty_.test(i)) continue;
+			// the first key is written without the leading comma
+			size_t iSkip = bFirst ? 1 : 0;
+			writer.writeRaw(keys[i].data() + iSkip, keys[i].size() - iSkip);
+			bFirst = false;
+
+			const void* value = JsonFieldValue(obj.data_, i);
+			const std::string* previous = obj.mergedText(i);
+			bool bValid = false;
+			if (previous)
+			{
+				Json::Value json;
+				std::ostringstream ss;
+				bValid = fields[i].codec->create(json, attrs[i], ss, value);
+				if (bValid)
+				{
+					Json::Value previousJson;
+					JsonExReader reader(previous->data(), previous->data() + previous->size());
+					reader.readValue(previousJson);
+					JsonExCodec::JsonMergeDiffWrite(writer, previousJson, json);
+				}
+				else err = ss.str();
+			}
+			else bValid = obj.replaced_.test(i) ? fields[i].codec->write(writer, attrs[i], err, value) : fields[i].codec->writePatch(writer, attrs[i], err, value);
+			if (!bValid)
+			{
+				err.insert(0, "." + std::get<attr_enum::AttrIndexName>(attrs[i]));
+				return false;
+			}
+		}
+		writer.writeChar('}');
+		return true;
+	}
+
+	// access to data object.
+	// Non-const access marks all the fields as changed, use get/set/modify methods to track changes per field.
+	data_type& data() { markAllDirty(); return data_; }
+	const data_type& data() const { return data_; }
+
+	// returns the tuple's field value
+	template<size_t _Index> const typename std::tuple_element<_Index, data_type>::type& get() const
+	{
+		return std::get<_Index>(data_);
+	}
+
+	// replaces the tuple's field value and marks the field as changed
+	template<size_t _Index, typename T> void set(T&& value)
+	{
+		std::get<_Index>(data_) = std::forward<T>(value);
+		markDirty(_Index);
+	}
+
+	// returns the tuple's field for modification in place and marks the field as changed.
+	// Nested JsonEx objects have to be modified by their own set/modify methods, so merge patch contains only their changed fields.
+	template<size_t _Index> typename std::tuple_element<_Index, data_type>::type& modify()
+	{
+		dirty_.set(_Index);
+		if (cache_) cache_->stale.set(_Index);
+		return std::get<_Index>(data_);
+	}
+
+	// returns true if any field is changed since the last clearDirty() call
+	bool isDirty() const { return dirty_.any(); }
+	// returns true if the field is changed since the last clearDirty() call
+	bool isDirty(size_t index) const { return dirty_.test(index); }
+
+	// marks the field as changed, it is written as a whole into merge patch
+	void markDirty(size_t index)
+	{
+		dirty_.set(index);
+		replaced_.set(index);
+		if (cache_) cache_->stale.set(index);
+	}
+	// marks all the fields as changed
+	void markAllDirty()
+	{
+		dirty_.set();
+		replaced_.set();
+		if (cache_) cache_->stale.set();
+	}
+	// resets changed fields, usually called after merge patch is sent.
+	// Keeps the text of the fields written as json objects (maps, variants), so the next merge patch removes their missing members.
+	// Does not affect cached json text.
+	void clearDirty()
+	{
+		dirty_.reset();
+		replaced_.reset();
+		merged_.clear();
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			fields[i].codec->clearDirty(JsonFieldValue(data_, i));
+			if (!fields[i].codec->merged) continue;
+			merged_.emplace_back(i, std::string());
+			JsonExWriter writer(merged_.back().second);
+			std::string err;
+			if (!fields[i].codec->write(writer, attrs[i], err, JsonFieldValue(data_, i))) merged_.pop_back();
+		}
+	}
+
+	// enables or disables caching of written json text.
+	// With caching enabled only changed fields are serialized on the next write.
+	// The cache is updated by const write methods, so concurrent writes of the same object are allowed
+	// only by the reentrant write(s, error) method, which uses the valid cache but does not update it.
+	// The cached text is the whole text of the object, so it is not for objects written to a sink by chunks.
+	void setCacheEnabled(bool enable)
+	{
+		if (!enable) cache_.reset();
+		else if (!cache_) cache_.reset(new JsonExCache());
+	}
+	bool isCacheEnabled() const { return cache_ != nullptr; }
+
+	// writes json merge patch with the changed fields into the string.
+	bool writeMergePatch(std::string& s) const
+	{
+		lastError_.clear();
+		s.clear();
+		JsonExWriter writer(s);
+		std::string err;
+		if (!JsonWriteMergePatch(writer, *this, err))
+		{
+			errorInfo_ = std::string("$") + err;
+			lastError_ = "Cannot create json merge patch";
+			return false;
+		}
+		return true;
+	}
+	// returns json merge patch with the changed fields
+	std::string getMergePatchString() const
+	{
+		std::string s;
+		writeMergePatch(s);
+		return s;
+	}
+
+	// unknown members of the last loaded json object, they are kept if data traits define keep_extras.
+	// The members are written after the fields and are not included into merge patch.
+	const JsonExExtras& extras() const { return extras_; }
+	// removes the unknown members, so they are not written anymore
+	void clearExtras()
+	{
+		extras_.clear();
+		if (cache_) cache_->stale.set();
+	}
+
+	// contains error json path and a message, can be used to identify invalid entries
+	const std::string& errorInfo() const
+	{
+		return errorInfo_;
+	}
+
+protected:
+	// cached json text of the object and positions of the fields' values in the text
+	struct JsonExCache
+	{
+		JsonExCache() { stale.set(); }
+
+		std::string bytes;
+		std::array<std::pair<size_t, size_t>, std::tuple_size<data_type>::value> spans;
+		// fields changed since the text was written
+		data_bits stale;
+	};
+
+	// main data storage
+	data_type data_;
+	// unknown members of json object
+	JsonExExtras extras_;
+	mutable std::string errorInfo_;
+	// fields changed since the last clearDirty() call
+	data_bits dirty_ = data_bits().set();
+	// changed fields replaced as a whole, not modified in place
+	data_bits replaced_ = data_bits().set();
+	// json text of the merged object fields at the last clearDirty() call by the field index
+	std::vector<std::pair<size_t, std::string>> merged_;
+	// optional cache of written json text, updated on write
+	std::unique_ptr<JsonExCache> cache_;
+
+protected:
+	bool validate(const Json::Value &root) const override
+	{
+		std::ostringstream err;
+		bool bValid = JsonValidate(root, err);
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err.str();
+		}
+		return bValid;
+	}
+	bool parse(const Json::Value &root) override
+	{
+		std::ostringstream err;
+		bool bValid = JsonParse(root, *this, err);
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err.str();
+		}
+		return bValid;
+	}
+	bool create(Json::Value &root) const override
+	{
+		std::ostringstream err;
+		bool bValid = JsonCreate(root, *this, err);
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err.str();
+		}
+		return bValid;
+	}
+	bool serialize(JsonExWriter &writer) const override
+	{
+		// overridden create() or validate() must apply to json text too, so the text is written from the created json object
+		if (JsonWriteHooked<_ImplT>(nullptr)) return JsonExBase::serialize(writer);
+		std::string err;
+		bool bValid = JsonWrite(writer, *this, err);
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err;
+		}
+		return bValid;
+	}
+	bool deserialize(JsonExReader &reader) override
+	{
+		// overridden validate() or parse() must get the json object, so it is read as the base class does
+		if (JsonReadHooked<_ImplT>::value) return JsonExBase::deserialize(reader);
+		// fields are read in json text order, so the error names the first invalid field of the text
+		std::string err;
+		bool bValid = JsonRead(reader, *this, err);
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err;
+		}
+		return bValid;
+	}
+	bool serializeShared(JsonExWriter &writer, std::string &err) const override
+	{
+		if (JsonWriteHooked<_ImplT>(nullptr))
+		{
+			Json::Value root;
+			if (!createShared(root, err)) return false;
+			writer.writeValue(root);
+			return true;
+		}
+		return JsonWrite(writer, *this, err);
+	}
+	bool createShared(Json::Value &root, std::string &err) const override
+	{
+		if (JsonWriteHooked<_ImplT>(nullptr))
+		{
+			if (create(root) && validate(root)) return true;
+			err = errorInfo_.empty() ? std::string() : errorInfo_.substr(1);
+			return false;
+		}
+		std::ostringstream ss;
+		bool bValid = JsonCreate(root, *this, ss);
+		if (!bValid) err = ss.str();
+		return bValid;
+	}
+
+protected:
+	// hooks declared by JsonEx, &_ImplT::hook has other type if _ImplT overrides the hook
+	typedef bool (JsonEx::*validate_hook)(const Json::Value &) const;
+	typedef bool (JsonEx::*create_hook)(Json::Value &) const;
+
+	// returns true if the JsonEx specialized type overrides create() or validate(),
+	// then json text is written from the json object they create and validate, as styled text is.
+	// An override which is not accessible here is detected too, it fails the first overload's substitution.
+	template<typename U> static bool JsonWriteHooked(typename std::enable_if<
+		std::is_same<decltype(&U::create), create_hook>::value && std::is_same<decltype(&U::validate), validate_hook>::value>::type*)
+	{
+		return false;
+	}
+	template<typename U> static bool JsonWriteHooked(...)
+	{
+		return true;
+	}
+
+	// hooks declared by JsonEx, &_ImplT::parse has other type if _ImplT overrides it
+	typedef bool (JsonEx::*parse_hook)(const Json::Value &);
+
+	// true if the JsonEx specialized type overrides validate() or parse(),
+	// then json text is read into json object which they validate and parse, as the base class does
+	template<typename U, typename = void> struct JsonReadHooked: std::true_type
+	{
+	};
+	template<typename U> struct JsonReadHooked<U, typename std::enable_if<
+		std::is_same<decltype(&U::parse), parse_hook>::value && std::is_same<decltype(&U::validate), validate_hook>::value>::type>: std::false_type
+	{
+	};
+
+	// indexes of the fields in json text order, the same order as Json::Value object has
+	typedef std::array<size_t, std::tuple_size<data_type>::value> field_order;
+	// quoted and escaped keys of the fields with the leading comma and the trailing colon: ,"name":
+	typedef std::array<std::string, std::tuple_size<data_type>::value> field_keys;
+	// shared codec of the field's type and the offset of the field in the data tuple
+	struct JsonExField
+	{
+		const JsonExFieldCodec* codec;
+		size_t offset;
+	};
+	// the only table of the field methods instantiated per JsonEx type
+	typedef std::array<JsonExField, std::tuple_size<data_type>::value> field_table;
+
+	// text of the merged object field at the last clearDirty() call, nullptr if there is no such text
+	const std::string* mergedText(size_t index) const
+	{
+		for (const std::pair<size_t, std::string>& item: merged_)
+		{
+			if (item.first == index) return &item.second;
+		}
+		return nullptr;
+	}
+
+	// unknown members of json object are kept as compact json text
+	static void JsonExtrasParse(const Json::Value& root, JsonExExtras& extras)
+	{
+		std::string text;
+		for (Json::Value::const_iterator it = root.begin(); it != root.end(); ++it)
+		{
+			const char* end = nullptr;
+			const char* name = it.memberName(&end);
+			if (JsonFieldFind(name, end) < std::tuple_size<data_type>::value) continue;
+			text.clear();
+			JsonExWriter writer(text);
+			writer.writeValue(*it);
+			extras.append(name, end - name, text.data(), text.size());
+		}
+	}
+
+	static const field_order& JsonFieldOrder()
+	{
+		static const field_order order = JsonMakeFieldOrder();
+		return order;
+	}
+
+	// keys text is prepared once per type, so writing a key is copying of the bytes only
+	static const field_keys& JsonFieldKeys()
+	{
+		static const field_keys keys = JsonMakeFieldKeys();
+		return keys;
+	}
+
+	static field_keys JsonMakeFieldKeys()
+	{
+		field_keys keys;
+		const data_attrs& attrs = data_traits::attributes();
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			const std::string& name = std::get<attr_enum::AttrIndexName>(attrs[i]);
+			JsonExWriter writer(keys[i]);
+			writer.writeChar(',');
+			writer.writeString(name);
+			writer.writeChar(':');
+		}
+		return keys;
+	}
+
+	static field_order JsonMakeFieldOrder()
+	{
+		field_order order;
+		for (size_t i = 0; i < order.size(); i++) order[i] = i;
+		const data_attrs& attrs = data_traits::attributes();
+		std::sort(order.begin(), order.end(), [&attrs](size_t a, size_t b)
+		{
+			return std::get<attr_enum::AttrIndexName>(attrs[a]) < std::get<attr_enum::AttrIndexName>(attrs[b]);
+		});
+		return order;
+	}
+
+	// returns the index of the field with the name, or the fields count if there is no such field
+	static size_t JsonFieldFind(const char* b, const char* e)
+	{
+		const field_order& order = JsonFieldOrder();
+		const data_attrs& attrs = data_traits::attributes();
+		size_t lo = 0;
+		size_t hi = order.size();
+		while (lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			int c = std::get<attr_enum::AttrIndexName>(attrs[order[mid]]).compare(0, std::string::npos, b, e - b);
+			if (c == 0) return order[mid];
+			if (c < 0) lo = mid + 1;
+			else hi = mid;
+		}
+		return order.size();
+	}
+
+	static const field_table& JsonFields()
+	{
+		static const field_table fields = JsonMakeFields(utils::make_index_sequence<std::tuple_size<data_type>::value>());
+		return fields;
+	}
+
+	template<size_t... _Index> static field_table JsonMakeFields(utils::index_sequence<_Index...>)
+	{
+		// std::tuple is not standard layout type, so the offsets are taken from the sample object
+		data_type sample;
+		const char* base = reinterpret_cast<const char*>(&sample);
+		return field_table{{ JsonExField{ &JsonExCodec::FieldCodec<typename std::tuple_element<_Index, data_type>::type>(),
+			static_cast<size_t>(reinterpret_cast<const char*>(&std::get<_Index>(sample)) - base) }... }};
+	}
+
+	static void JsonPrepareData(data_type& data, const data_type& source)
+	{
+		const field_table& fields = JsonFields();
+		for (size_t i = 0; i < fields.size(); i++)
+		{
+			if (fields[i].codec->prepare) fields[i].codec->prepare(JsonFieldValue(data, i), JsonFieldValue(source, i));
+		}
+	}
+
+	// returns the pointer to the field's value passed to the field's codec
+	static void* JsonFieldValue(data_type& data, size_t i)
+	{
+		return reinterpret_cast<char*>(&data) + JsonFields()[i].offset;
+	}
+	static const void* JsonFieldValue(const data_type& data, size_t i)
+	{
+		return reinterpret_cast<const char*>(&data) + JsonFields()[i].offset;
+	}
+
+	// writes object's fields in json text order, unchanged fields text is taken from the cache if it is set.
+	// Updates cache's positions of the fields if the cache is set.
+	static bool JsonWriteObject(JsonExWriter& writer, const JsonEx& obj, JsonExCache* cache, std::string& err)
+	{
+		const field_keys& keys = JsonFieldKeys();
+		const field_table& fields = JsonFields();
+		const data_attrs& attrs = data_traits::attributes();
+		std::array<std::pair<size_t, size_t>, std::tuple_size<data_type>::value> spans;
+
+		writer.writeChar('{');
+		bool bFirst = true;
+		for (size_t i: JsonFieldOrder())
+		{
+			// the first key is written without the leading comma
+			size_t iSkip = bFirst ? 1 : 0;
+			writer.writeRaw(keys[i].data() + iSkip, keys[i].size() - iSkip);
+			bFirst = false;
+
+			size_t begin = writer.buffer().size();
+			if (cache && !cache->stale.test(i))
+			{
+				writer.writeRaw(cache->bytes.data() + cache->spans[i].first, cache->spans[i].second - cache->spans[i].first);
+			}
+			else if (!fields[i].codec->write(writer, attrs[i], err, JsonFieldValue(obj.data_, i)))
+			{
+				err.insert(0, "." + std::get<attr_enum::AttrIndexName>(attrs[i]));
+				return false;
+			}
+			spans[i] = std::make_pair(begin, writer.buffer().size());
+		}
+		if (!obj.extras_.empty())
+		{
+			if (!bFirst) writer.writeChar(',');
+			writer.writeRaw(obj.extras_.text());
+		}
+		writer.writeChar('}');
+		if (cache) cache->spans = spans;
+		return true;
+	}
+
+};
+
+/*
+Discriminator field of JsonExVariant's alternative: the string field named as the discriminator member.
+It is set when the variant creates the alternative and checked before the alternative is written.
+*/
+template<typename K, typename T> struct JsonExVariantKey
+{
+	static void set(T& obj, const char* value)
+	{
+		if (field() < count) utils::for_each(obj.data(), Assign{ field(), value });
+	}
+	// returns false if the field has another value, or the alternative has no such string field
+	static bool matches(const T& obj, const char* value)
+	{
+		return field() < count && utils::find_if(obj.data(), Match{ field(), value }) < count;
+	}
+
+private:
+	static const size_t count = std::tuple_size<typename T::data_type>::value;
+
+	// index of the field, count if there is no such field
+	static size_t field()
+	{
+		static const size_t index = find();
+		return index;
+	}
+	static size_t find()
+	{
+		const typename JsonExDataTraits<T>::data_attrs& attrs = JsonExDataTraits<T>::attributes();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (std::get<JsonExAttributes::AttrIndexName>(attrs[i]) == K::name()) return i;
+		}
+		return count;
+	}
 
-		Json::Value& root_;
-		const data_attrs& names_;
-		std::ostream& err_;
+	struct Assign
+	{
+		size_t index;
+		const char* value;
+
+		void operator()(size_t i, std::string& s) const { if (i == index) s = value; }
+		template<typename U> void operator()(size_t, U&) const {}
 	};
+	struct Match
+	{
+		size_t index;
+		const char* value;
 
+		bool operator()(size_t i, const std::string& s) const { return i == index && s == value; }
+		template<typename U> bool operator()(size_t, const U&) const { return false; }
+	};
 };
 
 }
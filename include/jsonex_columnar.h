@@ -0,0 +1,299 @@
+// jsonex_columnar.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "jsonex.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+// values of one field for all the rows
+template<typename T> struct JsonExColumn
+{
+	typedef T value_type;
+
+	std::vector<T> values;
+
+	size_t size() const { return values.size(); }
+	bool isNull(size_t) const { return false; }
+	void resize(size_t rows) { values.resize(rows); }
+	void reserve(size_t rows) { values.reserve(rows); }
+};
+
+// values of utils::Nullable<T> field, null rows have default values and set bits in the nulls bitmap
+template<typename T> struct JsonExColumn<utils::Nullable<T>>
+{
+	typedef T value_type;
+
+	std::vector<T> values;
+	std::vector<uint64_t> nulls;
+
+	size_t size() const { return values.size(); }
+	bool isNull(size_t row) const { return ((nulls[row >> 6] >> (row & 63)) & 1) != 0; }
+	void setNull(size_t row, bool bNull)
+	{
+		uint64_t bit = uint64_t(1) << (row & 63);
+		if (bNull) nulls[row >> 6] |= bit;
+		else nulls[row >> 6] &= ~bit;
+	}
+	void resize(size_t rows)
+	{
+		values.resize(rows);
+		nulls.resize((rows + 63) / 64);
+		// bits of the removed rows are cleared, so the grown rows are not null
+		if (rows & 63) nulls.back() &= (uint64_t(1) << (rows & 63)) - 1;
+	}
+	void reserve(size_t rows)
+	{
+		values.reserve(rows);
+		nulls.reserve((rows + 63) / 64);
+	}
+};
+
+// tuple of the columns for the tuple of the fields
+template<typename TupleType> struct JsonExColumnsTuple;
+
+template<typename... T> struct JsonExColumnsTuple<std::tuple<T...>>
+{
+	typedef std::tuple<JsonExColumn<T>...> type;
+};
+
+/*
+Columnar (struct of arrays) decoding of JsonEx objects.
+Json array of objects or newline delimited json objects are read directly into one column per tuple's field,
+no JsonEx object is created. Fields are validated the same way as JsonEx::load() does,
+unknown members are skipped. Types overriding validate() or parse() are not supported, as no json object is created for them.
+Newline delimited objects must be separated by new lines.
+//Json::JsonExColumns<CSubObjType> columns;
+//bool b = columns.load(jsonArrayString);
+//const auto& a = columns.column<CSubObjType::data_enum::AttrA>();
+//long long sum = 0;
+//for (int v: a.values) sum += v;
+*/
+template<typename _ImplT> class JsonExColumns
+{
+	static_assert(!_ImplT::base_type::template JsonReadHooked<_ImplT>::value, "JsonExColumns does not call overridden validate() or parse()");
+
+public:
+	typedef typename _ImplT::base_type object_type;
+	typedef typename object_type::data_type data_type;
+	typedef typename object_type::data_traits data_traits;
+	typedef typename object_type::data_bits data_bits;
+	typedef typename object_type::attr_enum attr_enum;
+	typedef typename JsonExColumnsTuple<data_type>::type columns_type;
+
+public:
+	// count of the rows
+	size_t size() const { return rows_; }
+	bool empty() const { return rows_ == 0; }
+	void clear() { resize(0); }
+	void reserve(size_t rows) { utils::for_each(columns_, FnReserve(rows)); }
+
+	// column of the tuple's field
+	template<size_t _Index> const typename std::tuple_element<_Index, columns_type>::type& column() const
+	{
+		return std::get<_Index>(columns_);
+	}
+	const columns_type& columns() const { return columns_; }
+
+	// loads json array of objects.
+	// returns parse status, the columns are empty if the text is not valid.
+	bool load(const std::string& s) { return load(s, false); }
+	// loads newline delimited json objects, one object per line.
+	// returns parse status, the columns are empty if the text is not valid.
+	bool loadLines(const std::string& s) { return load(s, true); }
+
+	// returns the last error message of load
+	const std::string& lastError() const { return lastError_; }
+	// contains error json path and a message, can be used to identify invalid entries
+	const std::string& errorInfo() const { return errorInfo_; }
+
+protected:
+	bool load(const std::string& s, bool bLines)
+	{
+		clear();
+		lastError_.clear();
+		errorInfo_.clear();
+		std::string err;
+		bool bValid = true;
+		try
+		{
+			JsonExReader reader(s.data(), s.data() + s.size());
+			bValid = bLines ? readLines(reader, err) : readArray(reader, err);
+		}
+		catch (std::exception& e)
+		{
+			lastError_ = e.what();
+			clear();
+			return false;
+		}
+		if (!bValid)
+		{
+			errorInfo_ = std::string("$") + err;
+			lastError_ = "Input json object is not valid";
+			clear();
+		}
+		return bValid;
+	}
+
+	bool readArray(JsonExReader& reader, std::string& err)
+	{
+		if (reader.peek() != JsonExReader::tokenArray)
+		{
+			err = " -> invalid type, must be array.";
+			return false;
+		}
+		if (!reader.beginArray()) return true;
+		do
+		{
+			if (!readRow(reader, err)) return false;
+		} while (reader.nextElement());
+		return true;
+	}
+
+	bool readLines(JsonExReader& reader, std::string& err)
+	{
+		while (reader.peek() != JsonExReader::tokenEnd)
+		{
+			if (!readRow(reader, err)) return false;
+			if (!reader.skipLine()) reader.error("Syntax error: new line expected after the object.");
+		}
+		return true;
+	}
+
+	// reads the object into the next row of the columns
+	bool readRow(JsonExReader& reader, std::string& err)
+	{
+		size_t row = rows_;
+		if (reader.peek() != JsonExReader::tokenObject)
+		{
+			err = "[" + std::to_string(row) + "] -> invalid type, must be object.";
+			return false;
+		}
+		resize(row + 1);
+
+		const column_readers& readers = ColumnReaders();
+		data_bits found;
+		if (reader.beginObject())
+		{
+			do
+			{
+				const char* b = nullptr;
+				const char* e = nullptr;
+				reader.readKey(b, e, scratch_);
+				size_t i = object_type::JsonFieldFind(b, e);
+				if (i >= found.size())
+				{
+					reader.skipValue();
+					continue;
+				}
+				if (!readers[i](reader, columns_, row, err))
+				{
+					err.insert(0, "[" + std::to_string(row) + "]." + std::get<attr_enum::AttrIndexName>(data_traits::attributes()[i]));
+					return false;
+				}
+				found.set(i);
+			} while (reader.nextMember());
+		}
+
+		// missing fields have the same values as json null gives
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			if (found.test(i)) continue;
+			static const char null[] = "null";
+			JsonExReader nullReader(null, null + sizeof(null) - 1);
+			if (!readers[i](nullReader, columns_, row, err))
+			{
+				err.insert(0, "[" + std::to_string(row) + "]." + std::get<attr_enum::AttrIndexName>(data_traits::attributes()[i]));
+				return false;
+			}
+		}
+		rows_ = row + 1;
+		return true;
+	}
+
+	void resize(size_t rows)
+	{
+		utils::for_each(columns_, FnResize(rows));
+		rows_ = rows;
+	}
+
+protected:
+	// table of methods reading the field's value into the column's row
+	typedef bool (*column_read_fn)(JsonExReader&, columns_type&, size_t, std::string&);
+	typedef std::array<column_read_fn, std::tuple_size<data_type>::value> column_readers;
+
+	template<size_t _Index> static bool ColumnRead(JsonExReader& reader, columns_type& columns, size_t row, std::string& err)
+	{
+		return ColumnValueRead<_Index>(reader, std::get<_Index>(columns), row, err);
+	}
+
+	template<size_t _Index, typename T> static bool ColumnValueRead(JsonExReader& reader, JsonExColumn<T>& column, size_t row, std::string& err)
+	{
+		T v;
+		if (!JsonExCodec::JsonValueRead(reader, std::get<_Index>(data_traits::attributes()), err, v)) return false;
+		column.values[row] = std::move(v);
+		return true;
+	}
+
+	template<size_t _Index, typename T> static bool ColumnValueRead(JsonExReader& reader, JsonExColumn<utils::Nullable<T>>& column, size_t row, std::string& err)
+	{
+		if (reader.peek() == JsonExReader::tokenNull)
+		{
+			reader.readNull();
+			column.values[row] = T();
+			column.setNull(row, true);
+			return true;
+		}
+		T v;
+		if (!JsonExCodec::JsonValueRead(reader, std::get<_Index>(data_traits::attributes()), err, v)) return false;
+		column.values[row] = std::move(v);
+		column.setNull(row, false);
+		return true;
+	}
+
+	template<size_t... _Index> static column_readers MakeColumnReaders(utils::index_sequence<_Index...>)
+	{
+		return column_readers{{ &ColumnRead<_Index>... }};
+	}
+
+	static const column_readers& ColumnReaders()
+	{
+		static const column_readers readers = MakeColumnReaders(utils::make_index_sequence<std::tuple_size<data_type>::value>());
+		return readers;
+	}
+
+	// functors to resize and reserve all the columns
+	struct FnResize
+	{
+		explicit FnResize(size_t rows): rows_(rows) {}
+		template<typename T, size_t _Index> void operator() (std::integral_constant<size_t, _Index>, T& column) const { column.resize(rows_); }
+		size_t rows_;
+	};
+
+	struct FnReserve
+	{
+		explicit FnReserve(size_t rows): rows_(rows) {}
+		template<typename T, size_t _Index> void operator() (std::integral_constant<size_t, _Index>, T& column) const { column.reserve(rows_); }
+		size_t rows_;
+	};
+
+protected:
+	columns_type columns_;
+	size_t rows_ = 0;
+	// decoded keys with escape sequences
+	std::string scratch_;
+	std::string lastError_;
+	std::string errorInfo_;
+};
+
+}
+
+#pragma pack(pop)
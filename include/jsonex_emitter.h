@@ -0,0 +1,344 @@
+// jsonex_emitter.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "jsonex.h"
+#include "details/bounded_queue.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+// counters of the emitter, all the values are approximate while the emitter is working
+struct JsonExEmitterStats
+{
+	// items waiting in the queue and the maximal count of them
+	size_t queueDepth = 0;
+	size_t maxQueueDepth = 0;
+	// items written to the sink
+	size_t emitted = 0;
+	// items dropped because the queue was full
+	size_t dropped = 0;
+	// items which could not be serialized
+	size_t failed = 0;
+	// items of the batches which the sink failed to write
+	size_t lost = 0;
+	// batches and bytes written by the sink
+	size_t batches = 0;
+	size_t bytes = 0;
+};
+
+/*
+Asynchronous json emitter: objects are moved into the bounded lock-free queue,
+background threads serialize them into large buffers as newline delimited json and pass the buffers to the sink.
+The item type is JsonEx based type, or a smart pointer to JsonExBase to emit objects of different types.
+With several threads the order of the items is kept within one batch only.
+//Json::JsonExEmitter<CMainType> emitter(Json::JsonExEmitter<CMainType>::fileSink(1));
+//emitter.emit(std::move(event)); // returns immediately
+//emitter.flush(); // waits until all the emitted objects are written
+*/
+template<typename T> class JsonExEmitter
+{
+public:
+	// receives json text of the batch of objects, throws an exception if the text is not written
+	typedef std::function<void(const char*, size_t)> sink_type;
+
+	// behavior of emit() when the queue is full
+	enum overflow_policy
+	{
+		// waits until the queue has space, the thread sleeps until a serializing thread takes an object
+		overflowBlock,
+		// drops the emitted object
+		overflowDropNewest,
+		// drops the oldest object of the queue
+		overflowDropOldest
+	};
+
+	struct options
+	{
+		// maximal count of the queued objects
+		size_t capacity = 65536;
+		// count of the serializing threads
+		size_t threads = 1;
+		// batch buffer is passed to the sink when its size exceeds this value or the queue becomes empty
+		size_t batchBytes = 1 << 20;
+		overflow_policy overflow = overflowBlock;
+	};
+
+public:
+	explicit JsonExEmitter(sink_type sink): JsonExEmitter(std::move(sink), options()) {}
+	JsonExEmitter(sink_type sink, const options& opts): sink_(std::move(sink)), options_(opts), queue_(opts.capacity)
+	{
+		size_t threads = options_.threads ? options_.threads : 1;
+		for (size_t i = 0; i < threads; i++) threads_.emplace_back(&JsonExEmitter::work, this);
+	}
+	// writes all the queued objects and stops the threads
+	~JsonExEmitter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		wakeup_.notify_all();
+		for (std::thread& t: threads_) t.join();
+	}
+	JsonExEmitter(const JsonExEmitter&) = delete;
+	JsonExEmitter& operator=(const JsonExEmitter&) = delete;
+
+	// moves the object into the queue, returns false if the object is dropped
+	bool emit(T&& item)
+	{
+		// counted before pushing, so flush() never sees more finished objects than accepted ones
+		accepted_++;
+		while (!queue_.try_push(std::move(item)))
+		{
+			if (options_.overflow == overflowDropNewest)
+			{
+				accepted_--;
+				dropped_++;
+				return false;
+			}
+			if (options_.overflow == overflowDropOldest)
+			{
+				T oldest;
+				if (queue_.try_pop(oldest)) discard();
+				continue;
+			}
+			waitSpace();
+		}
+
+		size_t depth = queue_.size();
+		size_t maxDepth = maxDepth_.load(std::memory_order_relaxed);
+		while (depth > maxDepth && !maxDepth_.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {}
+
+		// pairs with the fence of the sleeping thread, so either the thread sees the object or it is woken up
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers_.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			wakeup_.notify_one();
+		}
+		return true;
+	}
+
+	// waits until all the emitted objects are passed to the sink
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		wakeup_.notify_all();
+		done_.wait(lock, [this]() { return finished_.load() == accepted_.load(); });
+	}
+
+	JsonExEmitterStats stats() const
+	{
+		JsonExEmitterStats s;
+		s.queueDepth = queue_.size();
+		s.maxQueueDepth = maxDepth_.load();
+		s.emitted = emitted_.load();
+		s.dropped = dropped_.load();
+		s.failed = failed_.load();
+		s.lost = lost_.load();
+		s.batches = batches_.load();
+		s.bytes = bytes_.load();
+		return s;
+	}
+
+	// sink writing to the file descriptor, throws std::system_error if the write fails
+	static sink_type fileSink(int fd)
+	{
+		return [fd](const char* p, size_t size)
+		{
+			while (size > 0)
+			{
+#if defined(_WIN32)
+				int written = _write(fd, p, static_cast<unsigned int>(size));
+#else
+				ssize_t written = ::write(fd, p, size);
+				if (written < 0 && errno == EINTR) continue;
+#endif
+				if (written <= 0) throw std::system_error(written < 0 ? errno : EIO, std::generic_category(), "JsonExEmitter sink write failed");
+				p += written;
+				size -= static_cast<size_t>(written);
+			}
+		};
+	}
+
+protected:
+	void work()
+	{
+		std::string buffer;
+		size_t count = 0;
+		for (;;)
+		{
+			T item;
+			if (queue_.try_pop(item))
+			{
+				// pairs with the fence of the blocked producer, so either it sees the space or it is woken up
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (blocked_.load() > 0)
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					space_.notify_all();
+				}
+				if (write(buffer, item)) count++;
+				if (buffer.size() < options_.batchBytes) continue;
+			}
+			if (!buffer.empty() || count)
+			{
+				writeBatch(buffer, count);
+				continue;
+			}
+
+			// the queue is empty, wait for new objects
+			std::unique_lock<std::mutex> lock(mutex_);
+			sleepers_++;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (queue_.empty())
+			{
+				if (stop_)
+				{
+					sleepers_--;
+					break;
+				}
+				wakeup_.wait_for(lock, std::chrono::milliseconds(100));
+			}
+			sleepers_--;
+		}
+	}
+
+	// appends the object's json text and the new line to the buffer, the buffer is not changed on error
+	bool write(std::string& buffer, const T& item)
+	{
+		size_t size = buffer.size();
+		const JsonExBase* obj = object(item);
+		bool bValid = false;
+		try
+		{
+			// the objects may be shared with other threads, so they are written without changes
+			JsonExWriter writer(buffer);
+			writer.setShared(true);
+			std::string err;
+			bValid = obj && obj->serializeShared(writer, err);
+		}
+		catch (std::exception&)
+		{
+			bValid = false;
+		}
+		if (!bValid)
+		{
+			buffer.resize(size);
+			failed_++;
+			finish(1);
+			return false;
+		}
+		buffer.push_back('\n');
+		return true;
+	}
+
+	void writeBatch(std::string& buffer, size_t& count)
+	{
+		bool bWritten = true;
+		if (!buffer.empty())
+		{
+			std::lock_guard<std::mutex> lock(sinkMutex_);
+			try
+			{
+				sink_(buffer.data(), buffer.size());
+			}
+			catch (std::exception&)
+			{
+				bWritten = false;
+			}
+		}
+		if (bWritten)
+		{
+			batches_++;
+			bytes_ += buffer.size();
+			emitted_ += count;
+		}
+		else lost_ += count;
+		finish(count);
+		buffer.clear();
+		count = 0;
+	}
+
+	// waits until the full queue has space for overflowBlock policy
+	void waitSpace()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		blocked_++;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		// the size is approximate, so the wait is limited
+		if (queue_.size() >= queue_.capacity()) space_.wait_for(lock, std::chrono::milliseconds(10));
+		blocked_--;
+	}
+
+	void discard()
+	{
+		dropped_++;
+		finish(1);
+	}
+
+	// counts processed objects and wakes up flush() waiting for them
+	void finish(size_t count)
+	{
+		if (!count) return;
+		finished_ += count;
+		std::lock_guard<std::mutex> lock(mutex_);
+		done_.notify_all();
+	}
+
+	static const JsonExBase* object(const JsonExBase& item) { return &item; }
+	template<typename U> static const JsonExBase* object(const std::unique_ptr<U>& item) { return item.get(); }
+	template<typename U> static const JsonExBase* object(const std::shared_ptr<U>& item) { return item.get(); }
+
+protected:
+	sink_type sink_;
+	std::mutex sinkMutex_;
+	options options_;
+	utils::BoundedQueue<T> queue_;
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+	std::condition_variable wakeup_;
+	std::condition_variable done_;
+	std::condition_variable space_;
+	std::atomic<int> sleepers_{ 0 };
+	// producers waiting for the space in the queue
+	std::atomic<int> blocked_{ 0 };
+	bool stop_ = false;
+
+	// emitted objects and objects written, dropped from the queue or failed
+	std::atomic<size_t> accepted_{ 0 };
+	std::atomic<size_t> finished_{ 0 };
+
+	std::atomic<size_t> maxDepth_{ 0 };
+	std::atomic<size_t> emitted_{ 0 };
+	std::atomic<size_t> dropped_{ 0 };
+	std::atomic<size_t> failed_{ 0 };
+	std::atomic<size_t> lost_{ 0 };
+	std::atomic<size_t> batches_{ 0 };
+	std::atomic<size_t> bytes_{ 0 };
+};
+
+}
+
+#pragma pack(pop)
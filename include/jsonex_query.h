@@ -0,0 +1,193 @@
+// jsonex_query.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include "jsonex.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Compiled json path with the same syntax as JsonEx::errorInfo() has:
+$ is the root value, .name is the object's member, [i] is the array's element.
+Names with dots or brackets can be written quoted: ["name.with.dots"].
+//Json::JsonExPath path("$.vecObj[0].b");
+*/
+class JsonExPath
+{
+public:
+	struct Step
+	{
+		// member's name, or element's index if isIndex is set
+		std::string name;
+		size_t index = 0;
+		bool isIndex = false;
+	};
+
+public:
+	// compiles the path, throws std::invalid_argument if the path is not valid
+	explicit JsonExPath(const std::string& path)
+	{
+		const char* p = path.data();
+		const char* end = p + path.size();
+		if (p == end || *p != '$') error(path, "must start with '$'");
+		p++;
+		while (p != end)
+		{
+			Step step;
+			if (*p == '.')
+			{
+				const char* name = ++p;
+				while (p != end && *p != '.' && *p != '[') p++;
+				if (p == name) error(path, "empty member name");
+				step.name.assign(name, p);
+			}
+			else if (*p == '[' && end - p > 1 && p[1] == '"')
+			{
+				// quoted name is json string
+				const char* name = p + 2;
+				const char* q = utils::json_find_quote(name, end);
+				while (q != end && *q == '\\') q = utils::json_find_quote(q + 2 < end ? q + 2 : end, end);
+				if (q == end || end - q < 2 || q[1] != ']') error(path, "missing '\"]'");
+				if (utils::json_unescape(step.name, name, q)) error(path, "bad escape sequence");
+				p = q + 2;
+			}
+			else if (*p == '[')
+			{
+				const char* digits = ++p;
+				for (; p != end && *p >= '0' && *p <= '9'; p++) step.index = step.index * 10 + static_cast<size_t>(*p - '0');
+				if (p == digits || p == end || *p != ']') error(path, "invalid array index");
+				p++;
+				step.isIndex = true;
+			}
+			else
+			{
+				error(path, "'.' or '[' expected");
+			}
+			steps_.push_back(std::move(step));
+		}
+	}
+
+	const std::vector<Step>& steps() const { return steps_; }
+
+private:
+	static void error(const std::string& path, const char* message)
+	{
+		throw std::invalid_argument("Invalid json path '" + path + "': " + message);
+	}
+
+private:
+	std::vector<Step> steps_;
+};
+
+/*
+Moves the reader to the value found by the path, returns false if there is no such value.
+The values before the found one are skipped at the token level without decoding,
+the text after the found value is not read at all. The first of duplicate members is found.
+Syntax errors of the read text are reported by std::invalid_argument exception.
+*/
+inline bool JsonExFind(JsonExReader& reader, const JsonExPath& path)
+{
+	std::string scratch;
+	for (const JsonExPath::Step& step: path.steps())
+	{
+		if (step.isIndex)
+		{
+			if (reader.peek() != JsonExReader::tokenArray || !reader.beginArray()) return false;
+			for (size_t i = 0; i < step.index; i++)
+			{
+				reader.skipValue();
+				if (!reader.nextElement()) return false;
+			}
+		}
+		else
+		{
+			if (reader.peek() != JsonExReader::tokenObject || !reader.beginObject()) return false;
+			for (;;)
+			{
+				const char* b = nullptr;
+				const char* e = nullptr;
+				reader.readKey(b, e, scratch);
+				if (step.name.compare(0, std::string::npos, b, e - b) == 0) break;
+				reader.skipValue();
+				if (!reader.nextMember()) return false;
+			}
+		}
+	}
+	return true;
+}
+
+// reading of the found value: basic types, enums, JsonEx based types, Json::Value and utils::Nullable of them
+template<typename T, typename std::enable_if< JsonExReadable<T>::value>::type * = nullptr>
+inline bool JsonExQueryRead(JsonExReader& reader, T& value)
+{
+	return reader.read(value);
+}
+
+template<typename T, typename std::enable_if< std::is_enum<T>::value>::type * = nullptr>
+inline bool JsonExQueryRead(JsonExReader& reader, T& value)
+{
+	std::string err;
+	return JsonExCodec::JsonValueRead(reader, JsonExCodec::attr_type(), err, value);
+}
+
+template<typename T, typename std::enable_if< std::is_base_of<JsonExBase, T>::value>::type * = nullptr>
+inline bool JsonExQueryRead(JsonExReader& reader, T& value)
+{
+	std::string err;
+	return T::JsonRead(reader, value, err);
+}
+
+inline bool JsonExQueryRead(JsonExReader& reader, Json::Value& value)
+{
+	reader.readValue(value);
+	return true;
+}
+
+template<typename T> inline bool JsonExQueryRead(JsonExReader& reader, utils::Nullable<T>& value)
+{
+	if (reader.peek() == JsonExReader::tokenNull)
+	{
+		reader.readNull();
+		value = nullptr;
+		return true;
+	}
+	T v;
+	if (!JsonExQueryRead(reader, v)) return false;
+	value = std::move(v);
+	return true;
+}
+
+/*
+Extracts the typed value by the path from json text without parsing the whole text.
+Returns false if the value is not found, has another type, or the text before it is not valid json.
+//int a = 0;
+//bool b = Json::JsonExQuery(text.data(), text.data() + text.size(), Json::JsonExPath("$.obj.a"), a);
+*/
+template<typename T> inline bool JsonExQuery(const char* begin, const char* end, const JsonExPath& path, T& value)
+{
+	try
+	{
+		JsonExReader reader(begin, end);
+		return JsonExFind(reader, path) && JsonExQueryRead(reader, value);
+	}
+	catch (std::invalid_argument&)
+	{
+		return false;
+	}
+}
+
+template<typename T> inline bool JsonExQuery(const std::string& text, const JsonExPath& path, T& value)
+{
+	return JsonExQuery(text.data(), text.data() + text.size(), path, value);
+}
+
+}
+
+#pragma pack(pop)
@@ -0,0 +1,136 @@
+// jsonex_snapshot.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+
+#include "jsonex.h"
+
+#pragma pack(push, 8)
+
+namespace Json
+{
+
+/*
+Immutable snapshots of JsonEx based config for hot reload. Each load reads the new text into a new object
+prepared from the current snapshot: JsonExShared fields whose text is not changed keep the values of the current snapshot,
+so the reload reads and allocates only the changed parts, and the snapshots share the rest.
+The new snapshot is published atomically, the readers keep the snapshot they got until they ask again.
+//Json::JsonExSnapshot<CConfigType> config;
+//config.load(text); // in the reloading thread
+//Json::JsonExSnapshot<CConfigType>::Reader reader(config); // one per worker thread
+//if (reader->limits) maxSize = reader->limits->maxSize;
+*/
+template<typename T> class JsonExSnapshot
+{
+public:
+	typedef std::shared_ptr<const T> pointer;
+
+	/*
+	Reader of the snapshots for one thread. It keeps the snapshot it got and checks the version on each access,
+	so the shared pointer is loaded only after the reload and the usual access is one atomic read.
+	*/
+	class Reader
+	{
+	public:
+		explicit Reader(const JsonExSnapshot& snapshot): snapshot_(snapshot), version_(snapshot.version()), current_(snapshot.get()) {}
+
+		// returns the current snapshot, the previous one is released if it was reloaded
+		const T& get()
+		{
+			uint64_t version = snapshot_.version();
+			if (version != version_)
+			{
+				current_ = snapshot_.get();
+				version_ = version;
+			}
+			return *current_;
+		}
+		const T& operator*() { return get(); }
+		const T* operator->() { return &get(); }
+
+	private:
+		const JsonExSnapshot& snapshot_;
+		uint64_t version_;
+		pointer current_;
+	};
+
+public:
+	JsonExSnapshot(): current_(std::make_shared<const T>()) {}
+	explicit JsonExSnapshot(pointer current): current_(std::move(current))
+	{
+		if (!current_) throw std::invalid_argument("JsonExSnapshot requires an object");
+	}
+	JsonExSnapshot(const JsonExSnapshot&) = delete;
+	JsonExSnapshot& operator=(const JsonExSnapshot&) = delete;
+
+	// returns the current snapshot, it is never changed and stays valid while the pointer is kept
+	pointer get() const { return std::atomic_load(&current_); }
+	// number of the published snapshots, changed after the new snapshot is published
+	uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+	// publishes the object as the current snapshot
+	void publish(pointer next)
+	{
+		if (!next) throw std::invalid_argument("JsonExSnapshot requires an object");
+		std::atomic_store(&current_, std::move(next));
+		version_.fetch_add(1, std::memory_order_release);
+	}
+
+	// reads json text into the new snapshot and publishes it, the current snapshot is kept on error
+	bool load(const std::string& s) { return load(s.data(), s.data() + s.size()); }
+	bool load(std::istream& is)
+	{
+		std::ostringstream oss;
+		oss << is.rdbuf();
+		return load(oss.str());
+	}
+	bool load(const char* b, const char* e);
+
+	// returns the error of the last load
+	JsonExError lastError() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return error_;
+	}
+
+private:
+	pointer current_;
+	std::atomic<uint64_t> version_{ 0 };
+	// loads are serialized, so each one is prepared from the snapshot published by the previous one
+	mutable std::mutex mutex_;
+	JsonExError error_;
+};
+
+template<typename T>
+inline bool JsonExSnapshot<T>::load(const char* b, const char* e)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	error_ = JsonExError();
+	std::shared_ptr<T> next = std::make_shared<T>();
+	std::string err;
+	try
+	{
+		T::JsonPrepare(*next, *get());
+		JsonExReader reader(b, e);
+		if (!T::JsonRead(reader, *next, err)) throw std::invalid_argument("Input json object is not valid");
+	}
+	catch (std::exception& ex)
+	{
+		error_.message = ex.what();
+		error_.info = err.empty() ? std::string() : std::string("$") + err;
+		return false;
+	}
+	publish(std::move(next));
+	return true;
+}
+
+}
+
+#pragma pack(pop)
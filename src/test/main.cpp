@@ -1,7 +1,12 @@
 // main.cpp
 
 #include <iostream>
+#include <thread>
 #include "jsonex.h"
+#include "jsonex_columnar.h"
+#include "jsonex_emitter.h"
+#include "jsonex_query.h"
+#include "jsonex_snapshot.h"
 
 using namespace utils;
 
@@ -81,6 +86,462 @@ public:
 	explicit CMainType(data_type&& other) : base_type(std::forward<data_type>(other)) {}
 };
 
+class CLabelsType; // forward declaration required
+
+// associative containers are json objects with any keys
+template<> struct Json::JsonExDataTraits<CLabelsType>
+{
+	enum data_enum : size_t
+	{
+		AttrCounters = 0, AttrTags = 1, AttrWeights = 2
+	};
+
+	using data_type = std::tuple<std::map<std::string, int>, std::unordered_map<std::string, std::string>, FlatMap<std::string, double> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	// unknown members are written back as they are
+	static const bool keep_extras = true;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("counters")), attr_type(std::string("tags")), attr_type(std::string("weights"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CLabelsType : public Json::JsonEx<CLabelsType>
+{
+public:
+	CLabelsType() = default;
+};
+
+class CRanksType; // forward declaration required
+
+// containers of other keys order are written sorted, the same as json object is
+template<> struct Json::JsonExDataTraits<CRanksType>
+{
+	enum data_enum : size_t
+	{
+		AttrRanks = 0
+	};
+
+	using data_type = std::tuple<std::map<std::string, int, std::greater<std::string>> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("ranks"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CRanksType : public Json::JsonEx<CRanksType>
+{
+public:
+	CRanksType() = default;
+};
+
+class CExportType; // forward declaration required
+
+// large arrays are streamed from the producer into the output
+template<> struct Json::JsonExDataTraits<CExportType>
+{
+	enum data_enum : size_t
+	{
+		AttrName = 0, AttrRows = 1
+	};
+
+	using data_type = std::tuple<std::string, Json::JsonExProducer<CSubObjType> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("name")), attr_type(std::string("rows"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CExportType : public Json::JsonEx<CExportType>
+{
+public:
+	CExportType() = default;
+};
+
+class CImportType; // forward declaration required
+
+// large arrays are passed to the consumer item by item while loading
+template<> struct Json::JsonExDataTraits<CImportType>
+{
+	enum data_enum : size_t
+	{
+		AttrName = 0, AttrRows = 1
+	};
+
+	using data_type = std::tuple<std::string, Json::JsonExConsumer<CSubObjType> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("name")), attr_type(std::string("rows"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CImportType : public Json::JsonEx<CImportType>
+{
+public:
+	CImportType() = default;
+};
+
+class CTickType; // forward declaration required
+
+// short arrays and strings are kept inside the object without heap allocations
+template<> struct Json::JsonExDataTraits<CTickType>
+{
+	enum data_enum : size_t
+	{
+		AttrSymbol = 0, AttrPrices = 1, AttrFlags = 2
+	};
+
+	using data_type = std::tuple<FixedString<8>, SmallVector<double, 4>, BoundedVector<int, 2> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("symbol")), attr_type(std::string("prices")), attr_type(std::string("flags"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CTickType : public Json::JsonEx<CTickType>
+{
+public:
+	CTickType() = default;
+};
+
+enum class EOrderState { New = 0, Filled = 1, Cancelled = 2 };
+
+// enum fields are written as names from the table
+template<> struct Json::JsonExEnumTraits<EOrderState>
+{
+	static const JsonExEnumNames<EOrderState>& names()
+	{
+		static const JsonExEnumNames<EOrderState> n{ { EOrderState::New, "new" }, { EOrderState::Filled, "filled" }, { EOrderState::Cancelled, "cancelled" } };
+		return n;
+	}
+};
+
+class COrderType; // forward declaration required
+
+template<> struct Json::JsonExDataTraits<COrderType>
+{
+	enum data_enum : size_t
+	{
+		AttrId = 0, AttrState = 1, AttrHistory = 2
+	};
+
+	using data_type = std::tuple<int, EOrderState, std::vector<EOrderState> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("id")), attr_type(std::string("state")), attr_type(std::string("history"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class COrderType : public Json::JsonEx<COrderType>
+{
+public:
+	COrderType() = default;
+};
+
+class CEventType; // forward declaration required
+
+// time points are written as RFC 3339 UTC strings, durations as numbers of their units
+template<> struct Json::JsonExDataTraits<CEventType>
+{
+	enum data_enum : size_t
+	{
+		AttrTime = 0, AttrTimeout = 1
+	};
+
+	using data_type = std::tuple<std::chrono::system_clock::time_point, std::chrono::milliseconds>;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("time")), attr_type(std::string("timeout"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CEventType : public Json::JsonEx<CEventType>
+{
+public:
+	CEventType() = default;
+};
+
+class CClickEvent; // forward declaration required
+class CKeyEvent; // forward declaration required
+
+// alternatives of the variant have the discriminator as their own field
+template<> struct Json::JsonExDataTraits<CClickEvent>
+{
+	enum data_enum : size_t
+	{
+		AttrType = 0, AttrX = 1, AttrY = 2
+	};
+
+	using data_type = std::tuple<std::string, int, int>;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("type")), attr_type(std::string("x")), attr_type(std::string("y"))
+			}
+		};
+		return attrs;
+	}
+
+	static const char* discriminator() { return "click"; }
+};
+
+class CClickEvent : public Json::JsonEx<CClickEvent>
+{
+public:
+	CClickEvent() = default;
+};
+
+template<> struct Json::JsonExDataTraits<CKeyEvent>
+{
+	enum data_enum : size_t
+	{
+		AttrType = 0, AttrKey = 1
+	};
+
+	using data_type = std::tuple<std::string, std::string>;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("type")), attr_type(std::string("key"))
+			}
+		};
+		return attrs;
+	}
+
+	static const char* discriminator() { return "key"; }
+};
+
+class CKeyEvent : public Json::JsonEx<CKeyEvent>
+{
+public:
+	CKeyEvent() = default;
+};
+
+// member name of the events' discriminator
+struct CEventKey
+{
+	static const char* name() { return "type"; }
+};
+
+using CInputEvent = Json::JsonExVariant<CEventKey, CClickEvent, CKeyEvent>;
+
+class CEnvelopeType; // forward declaration required
+
+template<> struct Json::JsonExDataTraits<CEnvelopeType>
+{
+	enum data_enum : size_t
+	{
+		AttrSource = 0, AttrEvents = 1
+	};
+
+	using data_type = std::tuple<std::string, std::vector<CInputEvent> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("source")), attr_type(std::string("events"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CEnvelopeType : public Json::JsonEx<CEnvelopeType>
+{
+public:
+	CEnvelopeType() = default;
+};
+
+class CConfigType; // forward declaration required
+
+template<> struct Json::JsonExDataTraits<CConfigType>
+{
+	enum data_enum : size_t
+	{
+		AttrName = 0, AttrLimits = 1, AttrRoutes = 2
+	};
+
+	using data_type = std::tuple<std::string, Json::JsonExShared<CSubObjType>, std::map<std::string, Json::JsonExShared<CSubObjType>> >;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("name")), attr_type(std::string("limits")), attr_type(std::string("routes"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CConfigType : public Json::JsonEx<CConfigType>
+{
+public:
+	CConfigType() = default;
+};
+
+class CSampleType; // forward declaration required
+
+template<> struct Json::JsonExDataTraits<CSampleType>
+{
+	enum data_enum : size_t
+	{
+		AttrHost = 0, AttrMetric = 1, AttrValue = 2
+	};
+
+	using data_type = std::tuple<InternedString, InternedString, double>;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("host")), attr_type(std::string("metric")), attr_type(std::string("value"))
+			}
+		};
+		return attrs;
+	}
+};
+
+class CSampleType : public Json::JsonEx<CSampleType>
+{
+public:
+	CSampleType() = default;
+};
+
+class CStampedType; // forward declaration required
+
+template<> struct Json::JsonExDataTraits<CStampedType>
+{
+	enum data_enum : size_t
+	{
+		AttrName = 0, AttrCount = 1
+	};
+
+	using data_type = std::tuple<std::string, int>;
+	using attr_type = JsonExAttributes::attr_type;
+	using data_attrs = std::array<attr_type, std::tuple_size<data_type>::value>;
+
+	static const data_attrs& attributes()
+	{
+		static const data_attrs attrs
+		{
+			{
+				attr_type(std::string("name")), attr_type(std::string("count"))
+			}
+		};
+		return attrs;
+	}
+};
+
+// overridden hooks apply to both compact and styled json
+class CStampedType : public Json::JsonEx<CStampedType>
+{
+public:
+	CStampedType() = default;
+
+	const std::string& stamp() const { return stamp_; }
+
+protected:
+	bool create(Json::Value &root) const override
+	{
+		if (!base_type::create(root)) return false;
+		root["stamp"] = "v1";
+		return true;
+	}
+	bool parse(const Json::Value &root) override
+	{
+		if (!base_type::parse(root)) return false;
+		stamp_ = root.get("stamp", "").asString();
+		return true;
+	}
+
+private:
+	std::string stamp_;
+};
+
 
 void TestJsonEx()
 {
@@ -145,11 +606,506 @@ void TestJsonEx()
 	std::cout << "Nullable test, streamed (non-styled): " << std::endl << Json::nostyled << nt << std::endl;
 }
 
+void TestJsonExChanges()
+{
+	std::cout << std::endl << "Changes tracking:" << std::endl;
+
+	CMainType jsonObj(std::make_tuple(true, 7890, std::vector<int>({ 11, 22, 33 }), nullptr, nullptr, nullptr));
+	jsonObj.setCacheEnabled(true);
+	std::cout << "JSON string: " << jsonObj.getJsonString(false) << std::endl;
+
+	// state is published, only changes are sent next time
+	jsonObj.clearDirty();
+	jsonObj.set<CMainType::data_enum::AttrUIntValue>(12345u);
+	jsonObj.modify<CMainType::data_enum::AttrVec>().push_back(44);
+
+	std::cout << "JSON merge patch: " << jsonObj.getMergePatchString() << std::endl;
+	std::cout << "JSON string (cached): " << jsonObj.getJsonString(false) << std::endl;
+}
+
+// applies RFC 7386 json merge patch to the json object
+void JsonMergePatchApply(Json::Value& target, const Json::Value& patch)
+{
+	if (!patch.isObject())
+	{
+		target = patch;
+		return;
+	}
+	if (!target.isObject()) target = Json::Value(Json::objectValue);
+	for (const std::string& name: patch.getMemberNames())
+	{
+		if (patch[name].isNull()) target.removeMember(name);
+		else JsonMergePatchApply(target[name], patch[name]);
+	}
+}
+
+void TestJsonExMaps()
+{
+	std::cout << std::endl << "Associative containers:" << std::endl;
+
+	CLabelsType labels;
+	if (!labels.load(std::string("{\"counters\":{\"b\":2,\"a\":1},\"tags\":{\"host\":\"srv1\",\"dc\":\"eu\"},\"weights\":{\"y\":0.5,\"x\":1.5}}")))
+	{
+		std::cout << "Load error: " << labels.lastError() << std::endl;
+		return;
+	}
+	std::cout << "weights[x]: " << labels.get<CLabelsType::data_enum::AttrWeights>().at("x") << std::endl;
+
+	// the receiver applies merge patch to its copy, removed keys are written as null
+	labels.clearDirty();
+	Json::Value received = labels.getJsonValue();
+	labels.modify<CLabelsType::data_enum::AttrCounters>()["c"] = 3;
+	labels.modify<CLabelsType::data_enum::AttrCounters>().erase("b");
+	FlatMap<std::string, double>& weights = labels.modify<CLabelsType::data_enum::AttrWeights>();
+	weights.erase(weights.begin());
+	Json::Value patch;
+	std::istringstream(labels.getMergePatchString()) >> patch;
+	JsonMergePatchApply(received, patch);
+	std::cout << "JSON string: " << labels.getJsonString(false) << std::endl;
+	std::cout << "JSON merge patch: " << labels.getMergePatchString() << ", applied: " << std::boolalpha << (received == labels.getJsonValue()) << std::endl;
+
+	CRanksType ranks;
+	ranks.modify<CRanksType::data_enum::AttrRanks>()["a"] = 1;
+	ranks.modify<CRanksType::data_enum::AttrRanks>()["b"] = 2;
+	std::string styled;
+	ranks.write(styled, true);
+	Json::Value json;
+	std::istringstream(styled) >> json;
+	std::cout << "JSON string: " << ranks.getJsonString(false) << ", the same as styled: " << std::boolalpha
+		<< (ranks.getJsonString(false) + "\n" == Json::FastWriter().write(json)) << std::endl;
+}
+
+void TestJsonExExtras()
+{
+	std::cout << std::endl << "Unknown members:" << std::endl;
+
+	CLabelsType labels;
+	labels.load(std::string("{\"counters\":{\"a\":1}, \"trace\": {\"id\": \"f00d\", \"hops\": [1, /* first */ 2]}, \"tags\":{}, \"weights\":{}}"));
+	for (size_t i = 0; i < labels.extras().size(); i++)
+	{
+		std::cout << "extra " << labels.extras().key(i) << ": " << labels.extras().value(i) << std::endl;
+	}
+
+	labels.modify<CLabelsType::data_enum::AttrCounters>()["b"] = 2;
+	std::cout << "JSON string: " << labels.getJsonString(false) << std::endl;
+}
+
+void TestJsonExColumns()
+{
+	std::cout << std::endl << "Columnar decoding:" << std::endl;
+
+	Json::JsonExColumns<CSubObjType> columns;
+	bool b = columns.load(std::string("[{\"a\": 1, \"b\": 10, \"v\": [1, 2, 3]}, {\"a\": 2, \"b\": 20}, {\"a\": 3, \"b\": 30, \"v\": null}]"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", rows: " << columns.size() << std::endl;
+
+	long long sum = 0;
+	for (int a: columns.column<CSubObjType::data_enum::AttrA>().values) sum += a;
+	const auto& v = columns.column<CSubObjType::data_enum::AttrV>();
+	size_t nulls = 0;
+	for (size_t i = 0; i < v.size(); i++) nulls += v.isNull(i) ? 1 : 0;
+	std::cout << "sum of a: " << sum << ", null v: " << nulls << std::endl;
+
+	b = columns.loadLines(std::string("{\"a\": 4, \"b\": 40}\n{\"a\": \"5\", \"b\": 50}\n"));
+	std::cout << "NDJSON load: Ok = " << b << ", Last error: " << columns.lastError() << ", JSON Error Attribute: " << columns.errorInfo() << std::endl;
+	// the objects must be on separate lines
+	b = columns.loadLines(std::string("{\"a\": 4, \"b\": 40} {\"a\": 5, \"b\": 50}\n"));
+	std::cout << "NDJSON load: Ok = " << b << ", Last error: " << columns.lastError();
+}
+
+void TestJsonExParallel()
+{
+	std::cout << std::endl << "Parallel writing:" << std::endl;
+
+	std::vector<CSubObjType> items;
+	for (int i = 0; i < 10000; i++)
+	{
+		items.push_back(CSubObjType(CSubObjType::data_type(i, i * 2, std::array<int, 3>{{ i, i + 1, i + 2 }})));
+	}
+
+	std::string sequential;
+	std::string parallel;
+	std::string err;
+	Json::JsonExWriter writer(sequential);
+	CSubObjType::JsonWriteArray(writer, items, err);
+
+	utils::ThreadPool pool(4);
+	Json::JsonExWriter parallelWriter(parallel, &pool);
+	CSubObjType::JsonWriteArray(parallelWriter, items, err);
+	std::cout << "JSON array size: " << parallel.size() << ", the same as sequential: " << std::boolalpha << (parallel == sequential) << std::endl;
+
+	parallel.clear();
+	CSubObjType::JsonWriteLines(parallelWriter, items, err);
+	std::cout << "NDJSON first line: " << parallel.substr(0, parallel.find('\n')) << std::endl;
+}
+
+void TestJsonExEmitter()
+{
+	std::cout << std::endl << "Asynchronous emitting:" << std::endl;
+
+	Json::JsonExEmitter<CSubObjType> emitter([](const char* p, size_t size) { std::cout.write(p, size); });
+	for (int i = 0; i < 3; i++)
+	{
+		emitter.emit(CSubObjType(CSubObjType::data_type(i, i * 10, nullptr)));
+	}
+	emitter.flush();
+
+	Json::JsonExEmitterStats stats = emitter.stats();
+	std::cout << "emitted: " << stats.emitted << ", dropped: " << stats.dropped << ", batches: " << stats.batches << std::endl;
+	// the batches which the sink fails to write are counted as lost
+	Json::JsonExEmitter<CSubObjType> failing([](const char*, size_t) { throw std::runtime_error("disk full"); });
+	failing.emit(CSubObjType(CSubObjType::data_type(1, 10, nullptr)));
+	failing.flush();
+	stats = failing.stats();
+	std::cout << "emitted: " << stats.emitted << ", lost: " << stats.lost << ", bytes: " << stats.bytes << std::endl;
+}
+
+void TestJsonExQuery()
+{
+	std::cout << std::endl << "Path queries:" << std::endl;
+
+	std::string text("{\"boolVal\": true, \"vec\": [1, 2, 3], \"obj\": {\"a\": 5, \"b\": 6}, \"vecObj\": [{\"a\": 7, \"b\": 8}]}");
+	int a = 0;
+	bool b = Json::JsonExQuery(text, Json::JsonExPath("$.obj.a"), a);
+	std::cout << "$.obj.a: Ok = " << std::boolalpha << b << ", value: " << a << std::endl;
+
+	CSubObjType sub;
+	b = Json::JsonExQuery(text, Json::JsonExPath("$.vecObj[0]"), sub);
+	std::string s;
+	sub.write(s, false);
+	std::cout << "$.vecObj[0]: Ok = " << b << ", JSON value: " << s << std::endl;
+
+	b = Json::JsonExQuery(text, Json::JsonExPath("$.vec[5]"), a);
+	std::cout << "$.vec[5]: Ok = " << b << std::endl;
+	b = Json::JsonExQuery(text, Json::JsonExPath("$.vec[1]"), s);
+	std::cout << "$.vec[1] as string: Ok = " << b << std::endl;
+}
+
+void TestJsonExShared()
+{
+	std::cout << std::endl << "Concurrent writing of shared object:" << std::endl;
+
+	CMainType mainType;
+	mainType.load(std::string("{\"boolVal\": true, \"uintVal\": 5, \"vec\": [1, 2, 3], \"obj\": {\"a\": 1, \"b\": 2, \"v\": null}}"));
+	mainType.setCacheEnabled(true);
+	const CMainType& shared = mainType;
+
+	std::vector<std::string> results(4);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		threads.emplace_back([&shared, &results, i]()
+		{
+			Json::JsonExError error;
+			for (int n = 0; n < 100; n++) shared.write(results[i], error);
+		});
+	}
+	for (std::thread& t: threads) t.join();
+
+	bool bSame = true;
+	for (const std::string& s: results) bSame = bSame && s == results[0];
+	std::cout << "JSON string: " << results[0] << ", the same in all threads: " << std::boolalpha << bSame << std::endl;
+}
+
+void TestJsonExProducer()
+{
+	std::cout << std::endl << "Streamed array:" << std::endl;
+
+	CExportType exportType;
+	exportType.set<CExportType::data_enum::AttrName>(std::string("export"));
+	// the rows are produced while the object is written, like a database cursor gives them
+	int row = 0;
+	exportType.set<CExportType::data_enum::AttrRows>(Json::JsonExProducer<CSubObjType>([&row](CSubObjType& obj)
+	{
+		if (row >= 1000) return false;
+		obj = CSubObjType(CSubObjType::data_type(row, row * 10, nullptr));
+		row++;
+		return true;
+	}));
+
+	// the rows can be produced once only, so they are not sized
+	size_t size = 0;
+	bool b = exportType.getJsonSize(size);
+	std::cout << "JSON size: Ok = " << std::boolalpha << b << ", error: " << exportType.errorInfo() << ", rows produced: " << row << std::endl;
+
+	size_t chunks = 0;
+	size_t bytes = 0;
+	b = exportType.write([&chunks, &bytes](const char*, size_t size) { chunks++; bytes += size; }, 4096);
+	std::cout << "JSON write: Ok = " << b << ", bytes: " << bytes << ", chunks: " << chunks << std::endl;
+}
+
+void TestJsonExConsumer()
+{
+	std::cout << std::endl << "Consumed array:" << std::endl;
+
+	CImportType importType;
+	long long sum = 0;
+	importType.set<CImportType::data_enum::AttrRows>(Json::JsonExConsumer<CSubObjType>([&sum](CSubObjType&& obj)
+	{
+		sum += obj.get<CSubObjType::data_enum::AttrB>();
+		return true;
+	}));
+
+	bool b = importType.load(std::string("{\"name\": \"import\", \"rows\": [{\"a\": 1, \"b\": 10}, {\"a\": 2, \"b\": 20}, {\"a\": 3, \"b\": 30}]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", rows: " << importType.get<CImportType::data_enum::AttrRows>().size() << ", sum of b: " << sum << std::endl;
+	// the consumer stops reading, the items are passed once and the rest of the text is not read
+	int calls = 0;
+	importType.set<CImportType::data_enum::AttrRows>(Json::JsonExConsumer<CSubObjType>([&calls](CSubObjType&&)
+	{
+		return ++calls < 2;
+	}));
+	b = importType.load(std::string("{\"rows\": [{\"a\": 1, \"b\": 10}, {\"a\": 2, \"b\": 20}, {\"a\": 3, \"b\": 30}], \"name\": \"x\"}"));
+	std::cout << "JSON load: Ok = " << b << ", calls: " << calls << ", error: " << importType.errorInfo()
+		<< ", name: " << importType.get<CImportType::data_enum::AttrName>() << std::endl;
+}
+
+void TestJsonExInline()
+{
+	std::cout << std::endl << "Inline containers:" << std::endl;
+
+	CTickType tick;
+	bool b = tick.load(std::string("{\"symbol\": \"EURUSD\", \"prices\": [1.1, 1.2, 1.3, 1.4, 1.5], \"flags\": [1, 2]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", symbol: " << tick.get<CTickType::data_enum::AttrSymbol>()
+		<< ", prices inline: " << tick.get<CTickType::data_enum::AttrPrices>().isInline() << std::endl;
+	std::cout << "JSON string: " << tick.getJsonString(false) << std::endl;
+
+	b = tick.load(std::string("{\"symbol\": \"EURUSD\", \"prices\": [], \"flags\": [1, 2, 3]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", error: " << tick.errorInfo() << std::endl;
+	b = tick.load(std::string("{\"symbol\": \"EURUSD.LONG\", \"prices\": [], \"flags\": []}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", error: " << tick.errorInfo() << std::endl;
+	// the item of the full vector is copied before the vector grows
+	SmallVector<std::string, 2> names{ "first", "second" };
+	names.push_back(names[0]);
+	std::cout << "Growing vector: " << names[2] << ", inline: " << names.isInline() << std::endl;
+}
+
+void TestJsonExEnum()
+{
+	std::cout << std::endl << "Enum fields:" << std::endl;
+
+	COrderType order;
+	bool b = order.load(std::string("{\"id\": 1, \"state\": \"filled\", \"history\": [\"new\", \"filled\"]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", filled: " << (order.get<COrderType::data_enum::AttrState>() == EOrderState::Filled) << std::endl;
+
+	order.set<COrderType::data_enum::AttrState>(EOrderState::Cancelled);
+	order.modify<COrderType::data_enum::AttrHistory>().push_back(EOrderState::Cancelled);
+	std::cout << "JSON string: " << order.getJsonString(false) << std::endl;
+
+	b = order.load(std::string("{\"id\": 2, \"state\": \"rejected\", \"history\": []}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", error: " << order.errorInfo() << std::endl;
+}
+
+void TestJsonExTime()
+{
+	std::cout << std::endl << "Time fields:" << std::endl;
+
+	CEventType event;
+	bool b = event.load(std::string("{\"time\": \"2024-05-01T15:30:45.250+03:00\", \"timeout\": 1500}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", timeout: " << event.get<CEventType::data_enum::AttrTimeout>().count() << " ms" << std::endl;
+	std::cout << "JSON string: " << event.getJsonString(false) << std::endl;
+
+	// epoch number of seconds is accepted too
+	b = event.load(std::string("{\"time\": 1714577445.5, \"timeout\": 0}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", JSON string: " << event.getJsonString(false) << std::endl;
+
+	b = event.load(std::string("{\"time\": \"2024-02-30T00:00:00Z\", \"timeout\": 0}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", error: " << event.errorInfo() << std::endl;
+}
+
+void TestJsonExSize()
+{
+	std::cout << std::endl << "Exact size writing:" << std::endl;
+
+	CMainType jsonObj(std::make_tuple(true, 7890, std::vector<int>({ 11, 22, 33 }), nullptr, nullptr, nullptr));
+	size_t size = 0;
+	bool b = jsonObj.getJsonSize(size);
+	std::string s;
+	s.reserve(size);
+	b = b && jsonObj.write(s);
+	std::cout << "JSON size: Ok = " << std::boolalpha << b << ", size: " << size << ", written: " << s.size() << std::endl;
+
+	// preallocated frame, the text must fit it
+	char frame[64];
+	b = jsonObj.write(frame, sizeof(frame), size);
+	std::cout << "JSON write to frame: Ok = " << std::boolalpha << b << ", error: " << jsonObj.lastError() << std::endl;
+	char largeFrame[256];
+	b = jsonObj.write(largeFrame, sizeof(largeFrame), size);
+	std::cout << "JSON write to frame: Ok = " << std::boolalpha << b << ", text: " << std::string(largeFrame, size) << std::endl;
+}
+
+void TestJsonExVariant()
+{
+	std::cout << std::endl << "Variant fields:" << std::endl;
+
+	CEnvelopeType envelope;
+	bool b = envelope.load(std::string("{\"source\": \"ui\", \"events\": [{\"type\": \"click\", \"x\": 10, \"y\": 20}, {\"key\": \"F1\", \"type\": \"key\"}]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", events: " << envelope.get<CEnvelopeType::data_enum::AttrEvents>().size() << std::endl;
+	for (const CInputEvent& event: envelope.get<CEnvelopeType::data_enum::AttrEvents>())
+	{
+		if (event.is<CClickEvent>()) std::cout << "click x: " << event.get<CClickEvent>().get<CClickEvent::data_enum::AttrX>() << std::endl;
+		if (event.is<CKeyEvent>()) std::cout << "key: " << event.get<CKeyEvent>().get<CKeyEvent::data_enum::AttrKey>() << std::endl;
+	}
+	std::cout << "JSON string: " << envelope.getJsonString(false) << std::endl;
+
+	b = envelope.load(std::string("{\"source\": \"ui\", \"events\": [{\"type\": \"scroll\"}]}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", error: " << envelope.errorInfo() << std::endl;
+	// emplace sets the discriminator, so the written events are loaded back
+	CEnvelopeType created;
+	std::vector<CInputEvent>& events = created.modify<CEnvelopeType::data_enum::AttrEvents>();
+	events.resize(2);
+	events[0].emplace<CClickEvent>().set<CClickEvent::data_enum::AttrX>(5);
+	events[1].emplaceIndex(1);
+	std::string text = created.getJsonString(false);
+	b = envelope.load(text);
+	std::cout << "JSON string: " << text << ", load: Ok = " << b << ", click: " << envelope.get<CEnvelopeType::data_enum::AttrEvents>()[0].is<CClickEvent>() << std::endl;
+	events[1].get<CKeyEvent>().set<CKeyEvent::data_enum::AttrType>(std::string("click"));
+	b = created.write(text);
+	std::cout << "JSON write: Ok = " << b << ", error: " << created.errorInfo() << std::endl;
+}
+
+void TestJsonExSegments()
+{
+	std::cout << std::endl << "Segments writing:" << std::endl;
+
+	// the long label is referenced in the object, it is not copied into the buffer
+	CLabelsType labels;
+	labels.modify<CLabelsType::data_enum::AttrTags>()["blob"] = std::string(4096, 'x');
+	labels.modify<CLabelsType::data_enum::AttrCounters>()["a"] = 1;
+
+	std::string buffer;
+	std::vector<Json::JsonExSegment> segments;
+	bool b = labels.write(buffer, segments);
+	size_t size = 0;
+	std::string joined;
+	for (const Json::JsonExSegment& segment: segments)
+	{
+		size += segment.size;
+		joined.append(segment.data, segment.size);
+	}
+	std::cout << "JSON write: Ok = " << std::boolalpha << b << ", segments: " << segments.size() << ", size: " << size
+		<< ", buffer: " << buffer.size() << ", the same as string: " << (joined == labels.getJsonString(false)) << std::endl;
+}
+
+void TestJsonExSnapshot()
+{
+	std::cout << std::endl << "Config snapshots:" << std::endl;
+
+	Json::JsonExSnapshot<CConfigType> config;
+	bool b = config.load(std::string("{\"name\": \"v1\", \"limits\": {\"a\": 1, \"b\": 2, \"v\": null}, "
+		"\"routes\": {\"api\": {\"a\": 3, \"b\": 4, \"v\": null}, \"web\": {\"a\": 5, \"b\": 6, \"v\": null}}}"));
+	Json::JsonExSnapshot<CConfigType>::pointer previous = config.get();
+	Json::JsonExSnapshot<CConfigType>::Reader reader(config);
+	std::cout << "JSON load: Ok = " << std::boolalpha << b << ", name: " << reader->get<CConfigType::data_enum::AttrName>() << std::endl;
+
+	// only the name and the web route are read again, the rest is shared with the previous snapshot
+	b = config.load(std::string("{\"name\": \"v2\", \"limits\": {\"a\": 1, \"b\": 2, \"v\": null}, "
+		"\"routes\": {\"api\": {\"a\": 3, \"b\": 4, \"v\": null}, \"web\": {\"a\": 7, \"b\": 6, \"v\": null}}}"));
+	const CConfigType& current = *reader;
+	const auto& routes = current.get<CConfigType::data_enum::AttrRoutes>();
+	const auto& previousRoutes = previous->get<CConfigType::data_enum::AttrRoutes>();
+	std::cout << "JSON reload: Ok = " << std::boolalpha << b << ", name: " << current.get<CConfigType::data_enum::AttrName>()
+		<< ", version: " << config.version()
+		<< ", limits shared: " << current.get<CConfigType::data_enum::AttrLimits>().shares(previous->get<CConfigType::data_enum::AttrLimits>())
+		<< ", api shared: " << routes.at("api").shares(previousRoutes.at("api"))
+		<< ", web shared: " << routes.at("web").shares(previousRoutes.at("web"))
+		<< ", web a: " << routes.at("web")->get<CSubObjType::data_enum::AttrA>() << std::endl;
+
+	b = config.load(std::string("{\"name\": 3}"));
+	std::cout << "JSON reload: Ok = " << std::boolalpha << b << ", error: " << config.lastError().info
+		<< ", name: " << reader->get<CConfigType::data_enum::AttrName>() << std::endl;
+}
+
+void TestJsonExInterned()
+{
+	std::cout << std::endl << "Interned strings:" << std::endl;
+
+	std::vector<CSampleType> samples(3);
+	bool b = samples[0].load(std::string("{\"host\": \"node-1\", \"metric\": \"cpu\", \"value\": 0.5}"));
+	b = b && samples[1].load(std::string("{\"host\": \"node-1\", \"metric\": \"mem\", \"value\": 0.25}"));
+	size_t count = InternTable::instance().size();
+	// the known strings are found in the table, nothing is added
+	b = b && samples[2].load(std::string("{\"host\": \"node\\u002d1\", \"metric\": \"cpu\", \"value\": 0.75}"));
+	std::cout << "JSON load: Ok = " << std::boolalpha << b
+		<< ", the same host: " << (samples[0].get<CSampleType::data_enum::AttrHost>() == samples[2].get<CSampleType::data_enum::AttrHost>())
+		<< ", the same text: " << (samples[0].get<CSampleType::data_enum::AttrHost>().data() == samples[1].get<CSampleType::data_enum::AttrHost>().data())
+		<< ", new strings: " << (InternTable::instance().size() - count) << std::endl;
+	std::cout << "JSON string: " << samples[2].getJsonString(false) << std::endl;
+	// the table of untrusted values is bounded, new strings over the limit fail the field
+	InternTable::instance().setLimit(InternTable::instance().size());
+	b = samples[2].load(std::string("{\"host\": \"node-1\", \"metric\": \"disk\", \"value\": 0.1}"));
+	std::cout << "JSON load: Ok = " << b << ", error: " << samples[2].errorInfo() << std::endl;
+	InternTable::instance().setLimit(std::numeric_limits<size_t>::max());
+}
+
+void TestJsonExHooks()
+{
+	std::cout << std::endl << "Overridden hooks:" << std::endl;
+
+	CStampedType stamped;
+	stamped.set<CStampedType::data_enum::AttrName>(std::string("a"));
+	std::string styled;
+	bool b = stamped.write(styled, true);
+	std::cout << "JSON write: Ok = " << std::boolalpha << b << ", compact: " << stamped.getJsonString(false)
+		<< ", styled has the stamp: " << (styled.find("\"stamp\"") != std::string::npos) << std::endl;
+	b = stamped.load(stamped.getJsonString(false));
+	std::cout << "JSON load: Ok = " << b << ", stamp: " << stamped.stamp() << std::endl;
+
+	// the first invalid field of json text is reported, the object is not changed
+	CSampleType sample;
+	b = sample.load(std::string("{\"metric\": \"m\", \"value\": \"x\", \"host\": 1}"));
+	std::cout << "JSON load: Ok = " << b << ", error: " << sample.errorInfo() << ", metric: " << sample.get<CSampleType::data_enum::AttrMetric>() << std::endl;
+}
+
+void TestJsonExReader()
+{
+	std::cout << std::endl << "Json text reader:" << std::endl;
+
+	// escapes are decoded and written back the same as jsoncpp does
+	std::string source = "tab\t quote\" slash\\ nl\n ctl\x01 utf8 \xc3\xa9 " + std::string(64, 'x');
+	CEnvelopeType envelope;
+	envelope.set<CEnvelopeType::data_enum::AttrSource>(source);
+	Json::Value json;
+	json["events"] = Json::Value(Json::arrayValue);
+	json["source"] = source;
+	std::string text = envelope.getJsonString(false);
+	bool b = envelope.load(text);
+	std::cout << "JSON escapes: the same as jsoncpp: " << std::boolalpha << (text + "\n" == Json::FastWriter().write(json))
+		<< ", load: Ok = " << b << ", the same string: " << (envelope.get<CEnvelopeType::data_enum::AttrSource>() == source) << std::endl;
+	b = envelope.load(std::string("{\"source\": \"\\u00e9\\ud83d\\ude00\", \"events\": []}"));
+	std::cout << "JSON load: Ok = " << b << ", source: " << envelope.get<CEnvelopeType::data_enum::AttrSource>() << std::endl;
+
+	// numbers are lenient as jsoncpp reader is, numbers out of range are errors
+	CSampleType sample;
+	b = sample.load(std::string("{\"host\": \"h\", \"metric\": \"m\", \"value\": 22.}"));
+	std::cout << "JSON load: Ok = " << b << ", value: " << sample.get<CSampleType::data_enum::AttrValue>() << std::endl;
+	b = sample.load(std::string("{\"host\": \"h\", \"metric\": \"m\", \"value\": 1.5e400}"));
+	std::cout << "JSON load: Ok = " << b << ", error: " << sample.lastError();
+}
+
 int main(int /*argc*/, char* /*argv*/[])
 {
 	std::cout << "Begin." << std::endl;
 
 	TestJsonEx();
+	TestJsonExChanges();
+	TestJsonExMaps();
+	TestJsonExExtras();
+	TestJsonExColumns();
+	TestJsonExParallel();
+	TestJsonExEmitter();
+	TestJsonExQuery();
+	TestJsonExShared();
+	TestJsonExProducer();
+	TestJsonExConsumer();
+	TestJsonExInline();
+	TestJsonExEnum();
+	TestJsonExTime();
+	TestJsonExSize();
+	TestJsonExVariant();
+	TestJsonExSegments();
+	TestJsonExSnapshot();
+	TestJsonExInterned();
+	TestJsonExHooks();
+	TestJsonExReader();
 
 	std::cout << std::endl << "End. Press enter to exit." << std::endl;
 	getchar();